@@ -10,29 +10,80 @@
  **/
 
 #include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
+#include <limits.h>
+#include <float.h>
+#include <math.h>
+#include <assert.h>
+
+#include <deque>
+#include <chrono>
+#include <charconv>
+#include <algorithm>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
 
 #include <sys/stat.h>
-#include <sys/varargs.h>
+#include <sys/mman.h>
+#include <stdarg.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+
+#ifndef MAP_FIXED_NOREPLACE
+   #define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+#ifdef __SSE2__
+   #include <emmintrin.h>
+#endif
 
 #include "Icejson.h"
 
 #define OK   true
 #define ERR  false
 
-#define SKIP_WHITE_SPACE(str, line, line_bgn)   \
-({                                              \
-   for( ; IS_SPACE(*str); str++)                \
-      if('\n' == *str)                          \
-      {                                         \
-         line++;                                \
-         line_bgn = str + 1;                    \
-      }                                         \
-})
+/* instrumentation, expands to nothing unless built with ICEJSON_STATS */
+#ifdef ICEJSON_STATS
+   #define STAT(ps, stmt) ({ if(ps) { stmt; } })
+   #define STAT_DECL(decl) decl
+   #define STAT_TIMER(ps, acc, less) \
+      Lap_t lap(ps ? &ps->acc : NULL, ps ? less : (long long *) NULL)
+#else
+   #define STAT(ps, stmt)
+   #define STAT_DECL(decl)
+   #define STAT_TIMER(ps, acc, less)
+#endif
+
+/* adds the time spent in a scope to acc and takes it off less; it
+ * reads the clock twice, so it times whole phases and never a token */
+struct Lap_t
+{
+   Lap_t(long long *acc, long long *less) : acc(acc), less(less)
+   {
+      if(acc)
+         bgn = std::chrono::steady_clock::now();
+   }
+
+   ~Lap_t()
+   {
+      if(acc)
+      {
+         long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - bgn).count();
+         *acc += ns;
+         if(less) *less -= ns;
+      }
+   }
 
-#define IS_SPACE(ch) (' ' == ch or '\t' == ch or '\r' == ch or '\n' == ch)
+   long long *acc;
+   long long *less;
+   std::chrono::steady_clock::time_point bgn;
+};
 
 struct Exception
 {
@@ -42,7 +93,7 @@ struct Exception
    const char *msg;
 
    Exception(const char *file, const char *fn, size_t line, const char *msg) :
-      file(file), fn(fn), line(line), msg(msg) {}
+      line(line), fn(fn), file(file), msg(msg) {}
 };
 
 #define trw_err(msg) throw Exception(__FILE__, __FUNCTION__, __LINE__, msg)
@@ -56,6 +107,7 @@ enum Symbol
    LEX_NULL             = 'N'    ,
    LEX_BOOL_TRUE        = 'T'    ,
    LEX_BOOL_FALSE       = 'F'    ,
+   LEX_NONFINITE        = 'i'    ,   /* NaN or Infinity */
 
    LEX_ARRAY_OPEN       = '['    ,
    LEX_ARRAY_CLOSE      = ']'    ,
@@ -69,6 +121,48 @@ enum Symbol
    LEX_INVALID          = 0x00
 };
 
+/* classes of a byte, looked up in char_class */
+enum CharClass
+{
+   CC_SPACE             = 0x01   ,   /* white space */
+   CC_DIGIT             = 0x02   ,
+   CC_TOKEN             = 0x04   ,   /* byte is its own Symbol */
+   CC_WORD              = 0x08   ,   /* letters, digits and underscore */
+   CC_HEX               = 0x10   ,
+   CC_ESCAPE            = 0x20       /* may follow a backslash in a string */
+};
+
+static const unsigned char char_class[256] =
+{
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x01, 0x00, 0x24, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x04, 0x00, 0x20,
+   0x1A, 0x1A, 0x1A, 0x1A, 0x1A, 0x1A, 0x1A, 0x1A, 0x1A, 0x1A, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08,
+   0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x04, 0x20, 0x04, 0x00, 0x08,
+   0x00, 0x18, 0x38, 0x18, 0x18, 0x18, 0x38, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x28, 0x08,
+   0x08, 0x08, 0x28, 0x08, 0x28, 0x28, 0x08, 0x08, 0x08, 0x08, 0x08, 0x04, 0x00, 0x04, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+#define IS_CLASS(ch, cc) (char_class[(unsigned char) (ch)] & (cc))
+
+/* compares 4 bytes as one word, word is a literal */
+static inline bool same_word(const char *str, const char *word)
+{
+   uint32_t lhs, rhs;
+   memcpy(&lhs, str, 4);
+   memcpy(&rhs, word, 4);
+   return lhs == rhs;
+}
+
 struct Lexer_t
 {
    Lexer_t();
@@ -76,176 +170,625 @@ struct Lexer_t
    Symbol cur_sym;
    const char *cur_pos;
    const char *json_str;
+   const char *json_end;      /* terminating NUL of json_str */
 
    int line;
    const char *line_bgn;
 
+   std::string scratch;       /* names with escapes are decoded here */
+   Icejson::Intern_t *pnames; /* names are interned into this */
+   Icejson::Arena_t *parena;  /* string values are copied into this */
+
+   int options;               /* ParseOptions, looked at only where
+                                 strict JSON would be rejected */
+   int depth;                 /* nesting of arrays and objects */
+   enum { MaxDepth = 1024 };  /* deeper input is refused before it
+                                 can run the stack out */
+   Icejson::Stats_t *pstats;  /* NULL when not collecting */
+
    void load_string(const char *json_arg);
 
    Symbol next();
    Symbol get_sym();
+   Symbol get_literal(const char *word, int len, Symbol sym);
+   void skip_space();
+   void skip_comment();
+   bool get_nonfinite(double &dval);
 
    Symbol get_str(std::string &val);
-   Symbol get_num(const char * &val);
+   char *get_escape(char *out);
+   unsigned get_hex4();
+   Symbol get_key(const char * &key, int &len, std::string &scratch);
+   Symbol get_number(long long &ival, double &dval);
    Symbol get_char(const char * &val);
+
+   Symbol skip_str();
+   Symbol skip_value();
+
+   /* where scanning stands, enough to come back to it as long as only
+    * values were read in between */
+   struct Mark_t
+   {
+      Symbol sym;
+      const char *pos;
+      int line;
+      const char *line_bgn;
+   };
+
+   Mark_t mark() const;
+   void rewind(const Mark_t &mk);
 };
 
 Lexer_t::Lexer_t()
 {
    line = 1;
+   depth = 0;
+   options = 0;
+   pstats = NULL;
+   pnames = NULL;
+   parena = NULL;
    line_bgn = NULL;
    cur_pos = NULL;
    json_str = NULL;
+   json_end = NULL;
 }
 
 void Lexer_t::load_string(const char *json_arg)
 {
    line_bgn = json_str = cur_pos = json_arg;
+   json_end = json_arg + strlen(json_arg);
    get_sym(); /* this will set cur_sym */
 }
 
+Lexer_t::Mark_t Lexer_t::mark() const
+{
+   Mark_t mk = { cur_sym, cur_pos, line, line_bgn };
+   return mk;
+}
+
+void Lexer_t::rewind(const Mark_t &mk)
+{
+   cur_sym = mk.sym;
+   cur_pos = mk.pos;
+   line = mk.line;
+   line_bgn = mk.line_bgn;
+}
+
 Symbol Lexer_t::next()
 {
    cur_pos++;
    return get_sym();
 }
 
+/* most runs are a single space or a newline and the indentation of
+ * the next line, the indentation is skipped 8 spaces at a time */
+void Lexer_t::skip_space()
+{
+   while(IS_CLASS(*cur_pos, CC_SPACE))
+   {
+      if('\n' == *cur_pos++)
+      {
+         line++;
+         line_bgn = cur_pos;
+
+         uint64_t val;
+         while(cur_pos + 8 <= json_end and 
+               (memcpy(&val, cur_pos, 8), 0x2020202020202020ULL == val))
+            cur_pos += 8;
+      }
+   }
+}
+
 Symbol Lexer_t::get_sym()
 {
-   SKIP_WHITE_SPACE(cur_pos, line, line_bgn);
+   STAT(pstats, pstats->tokens++);
+   skip_space();
    char ch = *cur_pos;
+
+   if(IS_CLASS(ch, CC_TOKEN))
+      return cur_sym = Symbol(ch);
+   if(IS_CLASS(ch, CC_DIGIT))
+      return cur_sym = LEX_INT;
+
    switch(ch)
    {
-      case LEX_NEG             :
-      case LEX_STRING          :
-      case LEX_ARRAY_OPEN      :
-      case LEX_ARRAY_CLOSE     :
-      case LEX_OBJECT_OPEN     :
-      case LEX_OBJECT_CLOSE    :
-      case LEX_NAME_SEPERATOR  :
-      case LEX_VALUE_SEPERATOR : cur_sym = Symbol(ch);
-                                 break;
+      case 't' : return get_literal("true", 4, LEX_BOOL_TRUE);
+      case 'f' : return get_literal("false", 5, LEX_BOOL_FALSE);
+      case 'n' : return get_literal("null", 4, LEX_NULL);
 
-      default  : if('0' <= ch and ch <= '9')
-                    cur_sym = LEX_INT;
-                 else if(0 == strncmp(cur_pos, "true", 4))
-                 {
-                    cur_sym  = LEX_BOOL_TRUE;
-                    cur_pos += 3;
-                 }
-                 else if(0 == strncmp(cur_pos, "false", 5))
-                 {
-                    cur_sym  = LEX_BOOL_FALSE;
-                    cur_pos += 4;
-                 }
-                 else if(0 == strncmp(cur_pos, "null", 4))
+      case 'N' :
+      case 'I' : if(options & Icejson::ParseOptions::NanInfinity)
+                    return cur_sym = LEX_NONFINITE;
+                 break;
+
+      case '/' : if(options & Icejson::ParseOptions::Comments)
                  {
-                    cur_sym  = LEX_NULL;
-                    cur_pos += 3;
+                    STAT(pstats, pstats->tokens--);
+                    skip_comment();
+                    return get_sym();
                  }
-                 else cur_sym = LEX_INVALID;
+                 break;
    }
-   return cur_sym;
+
+   return cur_sym = LEX_INVALID;
 }
 
-Symbol Lexer_t::get_num(const char * &val)
+/* the last 4 bytes of the literal are compared as one word and it
+ * must not run on into more letters, so trueX is not true */
+Symbol Lexer_t::get_literal(const char *word, int len, Symbol sym)
 {
-   val = cur_pos;
-   Symbol sym = LEX_INT;
+   if(json_end - cur_pos < len or *cur_pos != *word or 
+         not same_word(cur_pos + len - 4, word + len - 4) or
+         IS_CLASS(cur_pos[len], CC_WORD))
+      return cur_sym = LEX_INVALID;
+
+   cur_pos += len - 1;   /* left on the last byte like other symbols */
+   return cur_sym = sym;
+}
+
+/* moves past a line or block comment, a line comment is left on
+ * its newline so that skip_space counts the line */
+void Lexer_t::skip_comment()
+{
+   if('/' == cur_pos[1])
+   {
+      const char *eol = (const char *) memchr(cur_pos, '\n', json_end - cur_pos);
+      cur_pos = eol ? eol : json_end;
+   }
+   else if('*' == cur_pos[1])
+   {
+      for(cur_pos += 2; not ('*' == cur_pos[0] and '/' == cur_pos[1]); cur_pos++)
+      {
+         if('\0' == *cur_pos)
+            trw_err("Unterminated comment");
 
-   if('-' == *cur_pos and !isdigit(*++cur_pos))
+         if('\n' == *cur_pos)
+         {
+            line++;
+            line_bgn = cur_pos + 1;
+         }
+      }
+      cur_pos += 2;
+   }
+   else trw_err("Invalid comment");
+}
+
+/* NaN or Infinity following the sign, if the option allows them */
+bool Lexer_t::get_nonfinite(double &dval)
+{
+   int len = 0;
+
+   if(not (options & Icejson::ParseOptions::NanInfinity))
+      return false;
+
+   if(json_end - cur_pos >= 3 and 0 == memcmp(cur_pos, "NaN", 3))
+   {
+      len = 3;
+      dval = NAN;
+   }
+   else if(json_end - cur_pos >= 8 and same_word(cur_pos, "Infi") and
+         same_word(cur_pos + 4, "nity"))
+   {
+      len = 8;
+      dval = INFINITY;
+   }
+
+   if(0 == len or IS_CLASS(cur_pos[len], CC_WORD))
+      return false;
+
+   cur_pos += len;
+   return true;
+}
+
+/* digit kernels working on 4 or 8 ascii bytes at once (SWAR), the
+ * bytes are loaded little endian so the first digit is the low byte */
+static inline bool is_four_digits(uint32_t val)
+{
+   return 0x33333333 == ((val & 0xF0F0F0F0) |
+         (((val + 0x06060606) & 0xF0F0F0F0) >> 4));
+}
+
+static inline uint32_t four_digits(uint32_t val)
+{
+   val -= 0x30303030;
+   val = (val * 10) + (val >> 8);
+   return (val & 0xFF) * 100 + ((val >> 16) & 0xFF);
+}
+
+static inline bool is_eight_digits(uint64_t val)
+{
+   return 0x3333333333333333ULL == ((val & 0xF0F0F0F0F0F0F0F0ULL) |
+         (((val + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4));
+}
+
+static inline uint32_t eight_digits(uint64_t val)
+{
+   const uint64_t mask = 0x000000FF000000FFULL;
+   const uint64_t mul1 = 0x000F424000000064ULL;  /* 100 + (1000000 << 32) */
+   const uint64_t mul2 = 0x0000271000000001ULL;  /* 1 + (10000 << 32) */
+   val -= 0x3030303030303030ULL;
+   val = (val * 10) + (val >> 8);
+   return (((val & mask) * mul1) + (((val >> 16) & mask) * mul2)) >> 32;
+}
+
+/* accumulates a run of digits into mant, returns the digit count */
+static inline int scan_digits(const char * &str, const char *end, uint64_t &mant)
+{
+   const char *bgn = str;
+
+   while(str + 8 <= end)
+   {
+      uint64_t val;
+      memcpy(&val, str, 8);
+      if(not is_eight_digits(val)) break;
+      mant = mant * 100000000 + eight_digits(val);
+      str += 8;
+   }
+
+   if(str + 4 <= end)
+   {
+      uint32_t val;
+      memcpy(&val, str, 4);
+      if(is_four_digits(val))
+      {
+         mant = mant * 10000 + four_digits(val);
+         str += 4;
+      }
+   }
+
+   for( ; '0' <= *str and *str <= '9'; str++)
+      mant = mant * 10 + (*str - '0');
+
+   return str - bgn;
+}
+
+static const double pow10_exact[] =
+{
+   1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* scans and converts a number in one pass, the usual short numbers
+ * are converted exactly here and anything longer or with a large
+ * exponent is handed to strtoll / strtod */
+Symbol Lexer_t::get_number(long long &ival, double &dval)
+{
+
+   const char *bgn = cur_pos;
+   bool neg = ('-' == *cur_pos);
+   if(neg) cur_pos++;
+
+   uint64_t mant = 0;
+   int digits = scan_digits(cur_pos, json_end, mant);
+   if(0 == digits)
+   {
+      if(not get_nonfinite(dval))
          trw_err("Expected digit");
+      if(neg) dval = -dval;
+      get_sym();
+      return LEX_FLOAT;
+   }
 
-   while(isdigit(*cur_pos)) 
-      cur_pos++;
+   int exp10 = 0;
+   Symbol sym = LEX_INT;
 
-   if('.' == *cur_pos && isdigit(cur_pos[1]))
+   if('.' == *cur_pos and '0' <= cur_pos[1] and cur_pos[1] <= '9')
    {
+      cur_pos++;
       sym = LEX_FLOAT;
-      while(isdigit(*++cur_pos)); 
+      int frac = scan_digits(cur_pos, json_end, mant);
+      digits += frac;
+      exp10 -= frac;
    }
 
-   if('e' == *cur_pos || 'E' == *cur_pos)
+   if('e' == *cur_pos or 'E' == *cur_pos)
    {
       sym = LEX_FLOAT;
-      if(isdigit(*++cur_pos))
-         while(isdigit(*++cur_pos));
-      else if('+' == *cur_pos || '-' == *cur_pos)
+      bool eneg = false;
+      if('+' == *++cur_pos or '-' == *cur_pos)
+         eneg = ('-' == *cur_pos++);
+      if(not ('0' <= *cur_pos and *cur_pos <= '9'))
+         trw_err("Expected digit");
+
+      int exp = 0;
+      for( ; '0' <= *cur_pos and *cur_pos <= '9'; cur_pos++)
+         if(exp < 100000) exp = exp * 10 + (*cur_pos - '0');
+      exp10 += eneg ? -exp : exp;
+   }
+
+   if(LEX_INT == sym)
+   {
+      if(digits <= 18)
+         ival = neg ? -(long long) mant : (long long) mant;
+      else
       {
-         if(not isdigit(*++cur_pos))
-            trw_err("Expected digit");
-         while(isdigit(*++cur_pos));
+         /* out of the range of long long it is kept as a float
+          * rather than clamped */
+         errno = 0;
+         ival = strtoll(bgn, NULL, 10);
+         if(ERANGE == errno)
+         {
+            sym = LEX_FLOAT;
+            dval = strtod(bgn, NULL);
+         }
       }
    }
+   else if(digits <= 15 and -22 <= exp10 and exp10 <= 22)
+   {
+      dval = (double) mant;
+      dval = exp10 < 0 ? dval / pow10_exact[-exp10] : dval * pow10_exact[exp10];
+      if(neg) dval = -dval;
+   }
+   else
+   {
+      dval = strtod(bgn, NULL);
+   }
 
    get_sym();
 
    return sym;
 }
 
+/* decodes a string into val, stopping short at the end of the
+ * text rather than reading past it */
 Symbol Lexer_t::get_str(std::string &val)
 {
    cur_pos++;           /* skip string symbol */
    val.clear();
-   char arr[65] = {};
+   char arr[128];
+   char *out = arr;
 
-   for(int I = 0; '"' != *cur_pos; I++, cur_pos++)
+   for( ; ; )
    {
-      if(I >= 64)
+      /* plain bytes in a tight loop, keeping room for the longest
+       * escape which gives 4 bytes; pos is local as the stores to
+       * out could otherwise alias cur_pos */
+      const char *pos = cur_pos;
+      for(char *lim = arr + sizeof arr - 4; out < lim; pos++)
       {
-         I = 0;
-         val += arr;
-         memset(arr, 0, sizeof arr);
+         char ch = *pos;
+         if('"' == ch or '\\' == ch or '\n' == ch or '\0' == ch)
+            break;
+         *out++ = ch;
       }
+      cur_pos = pos;
 
-      if('\n' == *cur_pos)
+      if(out >= arr + sizeof arr - 4)
       {
-         line++;
-         line_bgn = cur_pos + 1;
+         val.append(arr, out - arr);
+         out = arr;
+         continue;
       }
-      
-      if('\\' == *cur_pos)
+
+      switch(*cur_pos)
       {
-         switch(*++cur_pos)
-         {
-            case '"'  : arr[I] = '"' ; break;
-            case '\\' : arr[I] = '\\'; break;
-            case '/'  : arr[I] = '/' ; break;
-            case 'b'  : arr[I] = '\b'; break;
-            case 'f'  : arr[I] = '\f'; break;
-            case 'n'  : arr[I] = '\n'; break;
-            case 'r'  : arr[I] = '\r'; break;
-            case 't'  : arr[I] = '\t'; break;
+         case '"'  : val.append(arr, out - arr);
+                     return get_sym();
 
-            case 'u'  : arr[I] = 0;
-                        for(int J = 0; J < 4 && cur_pos++; J++)
-                        {
-                           arr[I] <<= 4;
-                           char ch = *cur_pos;
-                           if('0' <= ch and ch <= '9')
-                              arr[I] |= (ch - '0');
-                           else if('a' <= ch and ch <= 'f')
-                              arr[I] |= (ch - 'a' + 0xA);
-                           else if('A' <= ch and ch <= 'F')
-                              arr[I] |= (ch - 'A' + 0xA);
-                           else trw_err("Invalid unicode value");
-                        }
-                        break;
+         case '\0' : return cur_sym = LEX_INVALID;
 
-            default   : trw_err("Invalid escape sequence");
-         }
+         case '\n' : line++;
+                     line_bgn = cur_pos + 1;
+                     *out++ = *cur_pos++;
+                     break;
+
+         case '\\' : STAT(pstats, pstats->escapes++);
+                     out = get_escape(out);
+                     break;
       }
-      else
+   }
+}
+
+/* the four hex digits following cur_pos, left on the last of them */
+unsigned Lexer_t::get_hex4()
+{
+   unsigned code = 0;
+
+   for(int I = 0; I < 4; I++)
+   {
+      char ch = *++cur_pos;
+      code <<= 4;
+      if('0' <= ch and ch <= '9')
+         code |= (ch - '0');
+      else if('a' <= ch and ch <= 'f')
+         code |= (ch - 'a' + 0xA);
+      else if('A' <= ch and ch <= 'F')
+         code |= (ch - 'A' + 0xA);
+      else trw_err("Invalid unicode value");
+   }
+
+   return code;
+}
+
+/* one escape sequence written to out, \u escapes as UTF-8 with a
+ * surrogate pair joined into one code point; an unpaired surrogate
+ * is encoded on its own so that nothing is lost */
+char *Lexer_t::get_escape(char *out)
+{
+   unsigned code = 0;
+
+   switch(*++cur_pos)
+   {
+      case '"'  : *out++ = '"' ; break;
+      case '\\' : *out++ = '\\'; break;
+      case '/'  : *out++ = '/' ; break;
+      case 'b'  : *out++ = '\b'; break;
+      case 'f'  : *out++ = '\f'; break;
+      case 'n'  : *out++ = '\n'; break;
+      case 'r'  : *out++ = '\r'; break;
+      case 't'  : *out++ = '\t'; break;
+
+      case 'u'  : code = get_hex4();
+                  if(0xD800 <= code and code < 0xDC00 and
+                        '\\' == cur_pos[1] and 'u' == cur_pos[2])
+                  {
+                     const char *high = cur_pos;
+                     cur_pos += 2;
+                     unsigned low = get_hex4();
+                     if(0xDC00 <= low and low < 0xE000)
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                     else
+                        cur_pos = high;   /* read again on its own */
+                  }
+
+                  if(code < 0x80)
+                     *out++ = (char) code;
+                  else if(code < 0x800)
+                  {
+                     *out++ = (char) (0xC0 | (code >> 6));
+                     *out++ = (char) (0x80 | (code & 0x3F));
+                  }
+                  else if(code < 0x10000)
+                  {
+                     *out++ = (char) (0xE0 | (code >> 12));
+                     *out++ = (char) (0x80 | ((code >> 6) & 0x3F));
+                     *out++ = (char) (0x80 | (code & 0x3F));
+                  }
+                  else
+                  {
+                     *out++ = (char) (0xF0 | (code >> 18));
+                     *out++ = (char) (0x80 | ((code >> 12) & 0x3F));
+                     *out++ = (char) (0x80 | ((code >> 6) & 0x3F));
+                     *out++ = (char) (0x80 | (code & 0x3F));
+                  }
+                  break;
+
+      default   : trw_err("Invalid escape sequence");
+   }
+
+   cur_pos++;
+   return out;
+}
+
+
+/* string, handed out in place when it has no escapes and
+ * decoded into scratch otherwise */
+Symbol Lexer_t::get_key(const char * &key, int &len, std::string &scratch)
+{
+   const char *bgn = cur_pos + 1, *end = bgn;
+   while('"' != *end and '\\' != *end and '\0' != *end and '\n' != *end)
+      end++;
+
+   if('"' == *end)
+   {
+      key = bgn;
+      len = end - bgn;
+      cur_pos = end;
+      return get_sym();
+   }
+
+   get_str(scratch);
+   key = scratch.data();
+   len = scratch.size();
+
+   return cur_sym;
+}
+
+/* same as get_str but only finds the end of the string */
+Symbol Lexer_t::skip_str()
+{
+   for(cur_pos++; '"' != *cur_pos; cur_pos++)
+   {
+      switch(*cur_pos)
       {
-         arr[I] = *cur_pos;
+         case '\0' : return cur_sym = LEX_INVALID;
+
+         case '\n' : line++;
+                     line_bgn = cur_pos + 1;
+                     break;
+
+         case '\\' : if(not IS_CLASS(*++cur_pos, CC_ESCAPE))
+                        trw_err("Invalid escape sequence");
+                     if('u' == *cur_pos)
+                        for(int I = 0; I < 4; I++)
+                           if(not IS_CLASS(*++cur_pos, CC_HEX))
+                              trw_err("Invalid unicode value");
+                     break;
       }
    }
-   
-   val += arr;
 
    return get_sym();
 }
 
+/* tracks nesting depth for the duration of a container parse */
+struct Depth_t
+{
+   Depth_t(Lexer_t &lex) : lex(lex)
+   {
+      if(++lex.depth > Lexer_t::MaxDepth)
+         trw_err("Nesting too deep");
+      STAT(lex.pstats, Icejson::Stats_t &st = *lex.pstats;
+                       if(lex.depth > st.max_depth) st.max_depth = lex.depth);
+   }
+
+   ~Depth_t() { lex.depth--; }
+
+   Lexer_t &lex;
+};
+
+/* moves past one complete value of any type, leaves cur_sym
+ * on the symbol following it */
+Symbol Lexer_t::skip_value()
+{
+   switch(cur_sym)
+   {
+      case LEX_NEG            :
+      case LEX_INT            :
+      case LEX_NONFINITE      : { long long ival = 0;
+                                  double dval = 0;
+                                  return get_number(ival, dval); }
+
+      case LEX_STRING         : if(LEX_STRING != skip_str())
+                                   trw_err("Unterminated string value");
+                                return next();
+
+      case LEX_NULL           :
+      case LEX_BOOL_TRUE      :
+      case LEX_BOOL_FALSE     : return next();
+
+      case LEX_ARRAY_OPEN     : { Depth_t nest(*this);
+                                if(LEX_ARRAY_CLOSE == next())
+                                   return next();
+                                for( ; ; )
+                                {
+                                   skip_value();
+                                   if(LEX_ARRAY_CLOSE == cur_sym)
+                                      return next();
+                                   if(LEX_VALUE_SEPERATOR != cur_sym)
+                                      trw_err("Expected value seperator");
+                                   if(LEX_ARRAY_CLOSE == next() and
+                                         (options & Icejson::ParseOptions::TrailingCommas))
+                                      return next();
+                                } }
+
+      case LEX_OBJECT_OPEN    : { Depth_t nest(*this);
+                                if(LEX_OBJECT_CLOSE == next())
+                                   return next();
+                                for( ; ; )
+                                {
+                                   if(LEX_STRING != cur_sym)
+                                      trw_err("Expected node name");
+                                   if(LEX_STRING != skip_str())
+                                      trw_err("Invalid node name");
+                                   if(LEX_NAME_SEPERATOR != next())
+                                      trw_err("Expected name seperator");
+                                   next();
+                                   skip_value();
+                                   if(LEX_OBJECT_CLOSE == cur_sym)
+                                      return next();
+                                   if(LEX_VALUE_SEPERATOR != cur_sym)
+                                      trw_err("Expected value seperator");
+                                   if(LEX_OBJECT_CLOSE == next() and
+                                         (options & Icejson::ParseOptions::TrailingCommas))
+                                      return next();
+                                } }
+
+      default : trw_err("Expected number, char, string, array or object");
+   }
+
+   return cur_sym;
+}
+
 
 /*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
  |        Parser related implementations starts      |
@@ -254,14 +797,105 @@ namespace Icejson
 {
    #define oInvalid (*((Node_t *)0))
 
+   /* bump allocator holding the string values of a tree, all of it
+    * is released at once when the document drops the tree */
+   struct Arena_t
+   {
+      enum { ChunkSize = 64 * 1024 };
+
+      vector<char *> chunks;
+      size_t used;
+
+      Arena_t() : used(ChunkSize) {}
+
+      ~Arena_t() { clear(); }
+
+      const char * copy(const char *str, int len)
+      {
+         char *ptr = NULL;
+         size_t size = len + 1;
+         if(size > ChunkSize / 4)
+         {
+            /* big strings get a chunk of their own, the current
+             * chunk stays the last one to allocate from */
+            chunks.insert(chunks.begin(), ptr = new char [size]);
+         }
+         else
+         {
+            if(used + size > ChunkSize)
+            {
+               chunks.push_back(new char [ChunkSize]);
+               used = 0;
+            }
+            ptr = chunks.back() + used;
+            used += size;
+         }
+         memcpy(ptr, str, len);
+         ptr[len] = '\0';
+         return ptr;
+      }
+
+      void clear()
+      {
+         for(size_t I = 0; I < chunks.size(); I++)
+            delete [] chunks[I];
+         chunks.clear();
+         used = ChunkSize;
+      }
+   };
+
    #define NEXT_NEW_NODE(ptr) \
    ({ \
          Parser_t *swp = new Parser_t(pdoc); \
          swp->pprev = pp; \
-         pp->pnext = pp = swp; \
+         pp->pnext = swp; \
+         pp = swp; \
          pp->pparent = this; \
     })
 
+   /* one step of the paths of a projection; a path may go on through
+    * members, through elements or through both, whichever the value
+    * there turns out to be */
+   struct Projection_t::Step_t
+   {
+      Step_t() : whole(false), pall(NULL) {}
+      ~Step_t();
+
+      bool whole;                            /* keeps everything below */
+      vector<pair<string, Step_t *> > members;
+      vector<pair<int, Step_t *> > items;    /* elements given by [N] */
+      Step_t *pall;                          /* elements given by [*] */
+
+      const Step_t * member(const char *key, int len) const
+      {
+         for(size_t I = 0; I < members.size(); I++)
+            if(len == (int) members[I].first.size() and
+                  0 == memcmp(key, members[I].first.data(), len))
+               return members[I].second;
+         return NULL;
+      }
+
+      const Step_t * item(int idx) const
+      {
+         for(size_t I = 0; I < items.size(); I++)
+            if(idx == items[I].first)
+               return items[I].second;
+         return pall;
+      }
+
+      /* whether a value starting with sym has anything to keep */
+      bool takes(Symbol sym) const
+      {
+         return whole or
+            (LEX_OBJECT_OPEN == sym and not members.empty()) or
+            (LEX_ARRAY_OPEN == sym and (pall or not items.empty()));
+      }
+   };
+
+   typedef Projection_t::Step_t Step_t;
+
+   struct Unpack_t;
+
    struct Parser_t : public Node_t
    {
       Parser_t(Doc_t *doc) { pdoc = doc; }
@@ -272,36 +906,110 @@ namespace Icejson
          vtype = type; 
       }
 
-      bool ParseArray(Lexer_t &lex);
-      bool ParseObject(Lexer_t &lex);
-      bool ParseNode(Lexer_t &lex, Symbol node_close);
+      /* Opts holds the ParseOptions which shape the containers,
+       * so that without them the loops carry no extra tests */
+      template <int Opts> bool ParseArray(Lexer_t &lex);
+      template <int Opts> bool ParsePacked(Lexer_t &lex);
+      template <int Opts> bool ParseObject(Lexer_t &lex);
+      template <int Opts> bool ParseNode(Lexer_t &lex, Symbol node_close);
+      template <int Opts> void ParseRoot(Lexer_t &lex, bool any_root);
+
+      /* same as above for a projected parse, values off the paths
+       * of step are skipped by the lexer */
+      template <int Opts> void ProjectArray(Lexer_t &lex, const Step_t *step);
+      template <int Opts> void ProjectObject(Lexer_t &lex, const Step_t *step);
+      template <int Opts> void ProjectNode(Lexer_t &lex, const Step_t *step, Symbol node_close);
+      template <int Opts> void ProjectRoot(Lexer_t &lex, const Step_t *step, bool any_root);
+
+      bool UnpackNode(Unpack_t &in);
+      void DropMember(Node_t *pn);
+
+      static void CountNode(Stats_t &st, Node_t *pn);
+
+      /* names of the object being parsed, for a duplicate policy;
+       * members are scanned until there are too many of them */
+      struct Seen_t
+      {
+         enum { ScanMax = 16 };
+
+         Seen_t() : pmap(NULL) {}
+         ~Seen_t() { delete pmap; }
+
+         Node_t * find(Parser_t *obj, Node_t *pn);
+         void keep(Node_t *pn) { if(pmap) (*pmap)[pn->name.sym()] = pn; }
+
+         unordered_map<const Sym_t *, Node_t *> *pmap;
+      };
    };
 
+   /* earlier member of obj named like pn, or NULL after noting pn */
+   Node_t * Parser_t::Seen_t::find(Parser_t *obj, Node_t *pn)
+   {
+      const Sym_t *sym = pn->name.sym();
+
+      if(NULL == pmap)
+      {
+         if(obj->pcount < ScanMax)
+         {
+            for(Node_t *itr = obj->vobj; itr != pn; itr = itr->pnext)
+               if(sym == itr->name.sym())
+                  return itr;
+            return NULL;
+         }
+
+         pmap = new unordered_map<const Sym_t *, Node_t *>;
+         for(Node_t *itr = obj->vobj; itr != pn; itr = itr->pnext)
+            (*pmap)[itr->name.sym()] = itr;
+      }
+
+      auto res = pmap->emplace(sym, pn);
+      return res.second ? NULL : res.first->second;
+   }
+
+   void Parser_t::CountNode(Stats_t &st, Node_t *pn)
+   {
+      st.bytes_allocated += sizeof(Parser_t);
+
+      switch(pn->vtype)
+      {
+         case Valtype::Int    : st.ints++;    break;
+         case Valtype::Float  : st.floats++;  break;
+         case Valtype::String : st.strings++;
+                                st.strings_copied++;
+                                st.bytes_allocated += pn->vlen + 1;
+                                break;
+         case Valtype::Bool   : st.bools++;   break;
+         case Valtype::Null   : st.nulls++;   break;
+         case Valtype::Array  : st.arrays++;  break;
+         case Valtype::Object : st.objects++; break;
+         case Valtype::Packed : st.arrays++;
+                                st.bytes_allocated += pn->pcount * 8;
+                                break;
+         default              : break;
+      }
+   }
+
+   template <int Opts>
    bool Parser_t::ParseNode(Lexer_t &lex, Symbol node_close)
    {
       switch(lex.cur_sym)
       {
          case LEX_NEG         : 
-         case LEX_INT         : const char *val;
-                                if(LEX_INT == lex.get_num(val))
-                                {
-                                   vint = atoi(val);
+         case LEX_NONFINITE   :
+         case LEX_INT         : if(LEX_INT == lex.get_number(vint, vreal))
                                    vtype = Valtype::Int;
-                                }
-                                else 
-                                {
-                                   vreal = atof(val);
+                                else
                                    vtype = Valtype::Float;
-                                }
                                 break;
 
-         case LEX_STRING      : lex.get_str(vstr);
+         case LEX_STRING      : lex.get_key(vstr, vlen, lex.scratch);
                                 if(LEX_STRING != lex.cur_sym)
                                 {
                                    trw_err("Unterminated string value");
                                 }
                                 else 
                                 { 
+                                   vstr = lex.parena->copy(vstr, vlen);
                                    lex.next(); 
                                    vtype = Valtype::String; 
                                    break; 
@@ -321,13 +1029,13 @@ namespace Icejson
                                 lex.next();
                                 break;
 
-         case LEX_ARRAY_OPEN  : ParseArray(lex);
-                                vtype = Valtype::Array;
+         case LEX_ARRAY_OPEN  : vtype = Valtype::Array;
+                                ParseArray<Opts>(lex); /* may turn it Packed */
                                 lex.next(); /* move past array close symbol */
                                 break;
 
-         case LEX_OBJECT_OPEN : ParseObject(lex);
-                                vtype = Valtype::Object;
+         case LEX_OBJECT_OPEN : vtype = Valtype::Object; /* freed as one on errors */
+                                ParseObject<Opts>(lex);
                                 lex.next(); /* move past object close symbol */
                                 break;
 
@@ -338,28 +1046,42 @@ namespace Icejson
             node_close != lex.cur_sym)
          trw_err("Expected value seperator");
 
+      STAT(lex.pstats, CountNode(*lex.pstats, this));
+
       return OK;
    }
 
+   template <int Opts>
    bool Parser_t::ParseArray(Lexer_t &lex)
    {
       Parser_t *pp = NULL;
+      Depth_t nest(lex);
 
       /* handle empty array */
       if(LEX_ARRAY_CLOSE == lex.next())
          return OK;
 
+      if(pdoc->pack_numbers and 
+            (LEX_INT == lex.cur_sym or LEX_NEG == lex.cur_sym or
+             LEX_NONFINITE == lex.cur_sym) and
+            ParsePacked<Opts>(lex))
+         return OK;
+
       pcount++;
       vobj = pp = new Parser_t(pdoc);
       pp->pparent = this;
-      pp->ParseNode(lex, LEX_ARRAY_CLOSE);
+      pp->ParseNode<Opts>(lex, LEX_ARRAY_CLOSE);
 
       while(LEX_ARRAY_CLOSE != lex.cur_sym)
       {
-         pcount++;
          lex.next();
+         if((Opts & ParseOptions::TrailingCommas) and 
+               LEX_ARRAY_CLOSE == lex.cur_sym)
+            break;
+
+         pcount++;
          NEXT_NEW_NODE(pp);
-         pp->ParseNode(lex, LEX_ARRAY_CLOSE);
+         pp->ParseNode<Opts>(lex, LEX_ARRAY_CLOSE);
       }
 
       vlast = pp;
@@ -367,23 +1089,106 @@ namespace Icejson
       return OK;
    }
 
+   /* parses an array of numbers of one type into one contiguous
+    * buffer, gives up and rewinds the lexer at the first element which
+    * is not a number of the type of the first so that ParseArray can
+    * build nodes instead; ints of a mixed array keep their type */
+   template <int Opts>
+   bool Parser_t::ParsePacked(Lexer_t &lex)
+   {
+      Lexer_t::Mark_t mark = lex.mark();
+      vector<long long> ints;
+      vector<double> floats;
+      Symbol type = LEX_INVALID;
+
+      for( ; ; lex.next())
+      {
+         if((Opts & ParseOptions::TrailingCommas) and 
+               LEX_ARRAY_CLOSE == lex.cur_sym)
+            break;
+
+         if(LEX_INT != lex.cur_sym and LEX_NEG != lex.cur_sym and
+               LEX_NONFINITE != lex.cur_sym)
+         {
+            lex.rewind(mark);
+            return ERR;
+         }
+
+         long long ival = 0;
+         double dval = 0;
+         Symbol sym = lex.get_number(ival, dval);
+         if(LEX_INVALID == type)
+            type = sym;
+         if(sym != type)
+         {
+            lex.rewind(mark);
+            return ERR;
+         }
+
+         if(LEX_FLOAT == sym) floats.push_back(dval);
+         else ints.push_back(ival);
+
+         if(LEX_ARRAY_CLOSE == lex.cur_sym)
+            break;
+         if(LEX_VALUE_SEPERATOR != lex.cur_sym)
+            trw_err("Expected value seperator");
+      }
+
+      if(LEX_FLOAT == type)
+      {
+         pcount = floats.size();
+         vfloats = new double [pcount];
+         memcpy(vfloats, floats.data(), pcount * sizeof(double));
+         vpacked = Valtype::Float;
+      }
+      else
+      {
+         pcount = ints.size();
+         vints = new long long [pcount];
+         memcpy(vints, ints.data(), pcount * sizeof(long long));
+         vpacked = Valtype::Int;
+      }
+      vtype = Valtype::Packed;
+
+      return OK;
+   }
+
+   template <int Opts>
    bool Parser_t::ParseObject(Lexer_t &lex)
    {
+      const int Dup = Opts & ParseOptions::DupPolicy;
       Parser_t *pp = NULL;
+      Node_t *pdup = NULL;
+      Seen_t seen;
+      Depth_t nest(lex);
       vobj = pp = new Parser_t(pdoc);
+      STAT(lex.pstats, lex.pstats->bytes_allocated += sizeof(Parser_t));
 
       while(LEX_OBJECT_CLOSE != lex.cur_sym)
       {
-         /* handle empty objects */
+         /* handle empty objects, and a trailing comma if allowed */
          if(LEX_OBJECT_CLOSE == lex.next())
+         {
+            if(vobj != pp and not (Opts & ParseOptions::TrailingCommas))
+               trw_err("Expected node name");
             break;
+         }
 
          if(LEX_STRING != lex.cur_sym)
             trw_err("Expected node name");
 
-         lex.get_str(pp->name);
-         if(LEX_STRING != lex.cur_sym)
+         int len = 0;
+         const char *key = NULL;
+         if(LEX_STRING != lex.get_key(key, len, lex.scratch))
             trw_err("Invalid node name");
+         pp->name.psym = lex.pnames->intern(key, len);
+
+         if(Dup)
+         {
+            pdup = seen.find(this, pp);
+            if(pdup and ParseOptions::DupError == Dup)
+               trw_err("Duplicate member name");
+         }
 
          if(LEX_NAME_SEPERATOR != lex.next())
             trw_err("Expected name seperator");
@@ -391,7 +1196,23 @@ namespace Icejson
          pcount++;
          lex.next();
          pp->pparent = this;
-         pp->ParseNode(lex, LEX_OBJECT_CLOSE);
+         pp->ParseNode<Opts>(lex, LEX_OBJECT_CLOSE);
+
+         if(Dup and pdup)
+         {
+            if(ParseOptions::DupLast == Dup)
+            {
+               DropMember(pdup);
+               seen.keep(pp);
+            }
+            else
+            {
+               Parser_t *prev = (Parser_t *) pp->pprev;
+               DropMember(pp);
+               pp = prev;
+            }
+         }
+
          NEXT_NEW_NODE(pp);
       }
 
@@ -408,20 +1229,279 @@ namespace Icejson
 
       return OK;
    }
+
+   /* root of parse_string, anything but an object has to be allowed */
+   template <int Opts>
+   void Parser_t::ParseRoot(Lexer_t &lex, bool any_root)
+   {
+      if(any_root)
+         ParseNode<Opts>(lex, LEX_INVALID);
+      else
+      {
+         if(LEX_OBJECT_OPEN != lex.cur_sym)
+            trw_err("Expected object at start");
+         vtype = Valtype::Object;
+         ParseObject<Opts>(lex);
+         lex.next();   /* move past object close symbol */
+      }
+
+      if('\0' != *lex.cur_pos)
+         trw_err("Unexpected data after root value");
+   }
+
+   /* a value off the paths, moved past without building anything */
+   static inline void skip_member(Lexer_t &lex, Symbol node_close)
+   {
+      lex.skip_value();
+      if(LEX_VALUE_SEPERATOR != lex.cur_sym and node_close != lex.cur_sym)
+         trw_err("Expected value seperator");
+   }
+
+   template <int Opts>
+   void Parser_t::ProjectNode(Lexer_t &lex, const Step_t *step, Symbol node_close)
+   {
+      if(step->whole or 
+            (LEX_OBJECT_OPEN != lex.cur_sym and LEX_ARRAY_OPEN != lex.cur_sym))
+      {
+         ParseNode<Opts>(lex, node_close);
+         return;
+      }
+
+      if(LEX_OBJECT_OPEN == lex.cur_sym)
+      {
+         vtype = Valtype::Object;
+         ProjectObject<Opts>(lex, step);
+      }
+      else
+      {
+         vtype = Valtype::Array;
+         ProjectArray<Opts>(lex, step);
+      }
+      lex.next(); /* move past the close symbol */
+
+      if(LEX_VALUE_SEPERATOR != lex.cur_sym and 
+            node_close != lex.cur_sym)
+         trw_err("Expected value seperator");
+
+      STAT(lex.pstats, CountNode(*lex.pstats, this));
+   }
+
+   template <int Opts>
+   void Parser_t::ProjectArray(Lexer_t &lex, const Step_t *step)
+   {
+      Parser_t *pp = NULL;
+      Depth_t nest(lex);
+
+      /* handle empty array */
+      if(LEX_ARRAY_CLOSE == lex.next())
+         return;
+
+      for(int idx = 0; ; idx++)
+      {
+         const Step_t *sub = step->item(idx);
+         if(sub and sub->takes(lex.cur_sym))
+         {
+            Parser_t *pn = new Parser_t(pdoc);
+            pn->pparent = this;
+            pn->pprev = pp;
+            if(pp) pp->pnext = pn;
+            else vobj = pn;
+            pp = pn;
+            pcount++;
+            pn->ProjectNode<Opts>(lex, sub, LEX_ARRAY_CLOSE);
+         }
+         else skip_member(lex, LEX_ARRAY_CLOSE);
+
+         if(LEX_ARRAY_CLOSE == lex.cur_sym)
+            break;
+         if(LEX_ARRAY_CLOSE == lex.next() and
+               (Opts & ParseOptions::TrailingCommas))
+            break;
+      }
+
+      vlast = pp;
+   }
+
+   template <int Opts>
+   void Parser_t::ProjectObject(Lexer_t &lex, const Step_t *step)
+   {
+      const int Dup = Opts & ParseOptions::DupPolicy;
+      Parser_t *pp = NULL;
+      Depth_t nest(lex);
+
+      for(bool first = true; LEX_OBJECT_CLOSE != lex.cur_sym; first = false)
+      {
+         /* handle empty objects, and a trailing comma if allowed */
+         if(LEX_OBJECT_CLOSE == lex.next())
+         {
+            if(not first and not (Opts & ParseOptions::TrailingCommas))
+               trw_err("Expected node name");
+            break;
+         }
+
+         if(LEX_STRING != lex.cur_sym)
+            trw_err("Expected node name");
+
+         /* only names on the paths are interned */
+         int len = 0;
+         const char *key = NULL;
+         if(LEX_STRING != lex.get_key(key, len, lex.scratch))
+            trw_err("Invalid node name");
+         const Step_t *sub = step->member(key, len);
+         const Sym_t *sym = sub ? lex.pnames->intern(key, len) : NULL;
+
+         if(LEX_NAME_SEPERATOR != lex.next())
+            trw_err("Expected name seperator");
+         lex.next();
+
+         if(NULL == sub or not sub->takes(lex.cur_sym))
+         {
+            skip_member(lex, LEX_OBJECT_CLOSE);
+            continue;
+         }
+
+         if(Dup)
+         {
+            Node_t *pdup = vobj;
+            while(pdup and sym != pdup->name.sym())
+               pdup = pdup->pnext;
+
+            if(pdup and ParseOptions::DupError == Dup)
+               trw_err("Duplicate member name");
+
+            if(pdup and ParseOptions::DupFirst == Dup)
+            {
+               skip_member(lex, LEX_OBJECT_CLOSE);   /* first one stays */
+               continue;
+            }
+
+            if(pdup)
+            {
+               if(pdup == pp) pp = (Parser_t *) pp->pprev;
+               DropMember(pdup);
+            }
+         }
+
+         Parser_t *pn = new Parser_t(pdoc);
+         pn->name.psym = sym;
+         pn->pparent = this;
+         pn->pprev = pp;
+         if(pp) pp->pnext = pn;
+         else vobj = pn;
+         pp = pn;
+         pcount++;
+         pn->ProjectNode<Opts>(lex, sub, LEX_OBJECT_CLOSE);
+      }
+
+      vlast = pp;
+   }
+
+   template <int Opts>
+   void Parser_t::ProjectRoot(Lexer_t &lex, const Step_t *step, bool any_root)
+   {
+      if(any_root)
+         ProjectNode<Opts>(lex, step, LEX_INVALID);
+      else
+      {
+         if(LEX_OBJECT_OPEN != lex.cur_sym)
+            trw_err("Expected object at start");
+         vtype = Valtype::Object;
+         if(step->whole)
+            ParseObject<Opts>(lex);
+         else
+            ProjectObject<Opts>(lex, step);
+         lex.next();   /* move past object close symbol */
+      }
+
+      if('\0' != *lex.cur_pos)
+         trw_err("Unexpected data after root value");
+   }
 }
 
 
 namespace Icejson
 {
+   struct Layout_t;
+   struct Image_t;
+   struct Diff_t;
+   struct Elem_t;
+   struct Pointer_t;
+
+   /* element nodes of packed arrays, kept aside so that the packed
+    * buffer and the node stay as they are for readers on other
+    * threads and for read-only snapshot pages */
+   struct Views_t
+   {
+      mutex mtx;
+      unordered_map<const Node_t *, Node_t *> nodes;
+
+      void clear()
+      {
+         for(auto &itr : nodes)
+            delete [] itr.second;
+         nodes.clear();
+      }
+   };
+
    struct Helper_t
    {
       static void free_node(Node_t * &pnode);
+      static void free_root(Doc_t *pdoc, Node_t * &pnode);
+      static void pack(string &out, Node_t *pn);
+
+      /* document of a node, also for nodes of a mapped snapshot */
+      static Doc_t * owner(const Node_t *pn);
+      static const Sym_t * find_name(Doc_t *pdoc, const char *str, int len);
+
+      static void measure(Node_t *pn, Layout_t &lay);
+      static void place(Layout_t &lay, Node_t &dst, const Node_t *src);
+      static void move_node(Node_t *pn, intptr_t delta);
+      static bool check_image(const char *img, const Image_t &hdr);
+      static void save_image(const char *file_path, Node_t *root);
+      static Snapshot_t * map_image(const char *file_path, Doc_t *pdoc);
+      static void unmap_image(Snapshot_t *psnap);
+
+      static uint64_t hash_node(const Node_t *pn);
+      static void touch(Node_t *pn);
+      static void canonical(string &out, const Node_t *pn);
+
+      static bool number(const Node_t *pn, int pos, int &type, uint64_t &bits);
+      static void elems(const Node_t *pn, vector<Elem_t> &vec);
+      static int diff(const Node_t *from, const Node_t *to, string &out);
+      static void diff_node(Diff_t &df, const Node_t *a, const Node_t *b);
+      static void diff_object(Diff_t &df, const Node_t *a, const Node_t *b);
+      static void diff_array(Diff_t &df, const Node_t *a, const Node_t *b);
+      static void emit(Diff_t &df, const char *op, const Node_t *pn = NULL, int pos = -1);
+      static void append_json(string &out, const Node_t *pn, int pos = -1);
+
+      static const Node_t * member(const Node_t *obj, const char *name);
+      static bool same(const Node_t *a, const Node_t *b);
+      static bool same_members(const Node_t *a, const Node_t *b);
+      static Node_t * clone(Doc_t *pdoc, const Node_t *src);
+      static void unpack(Doc_t *pdoc, Node_t *pn);
+      static Node_t * element(const Node_t *pn, int idx);
+      static void drop_view(Node_t *pn);
+      static void attach(Node_t *parent, Node_t *pn, Node_t *pos);
+      static void detach(Node_t *pn);
+      static void resolve(Doc_t *pdoc, const char *path, Pointer_t &ptr, bool write);
+      static void put(Doc_t *pdoc, Pointer_t &ptr, Node_t *pn, bool replace);
+      static void apply_op(Doc_t *pdoc, const Node_t *op, Pointer_t &ptr);
+      static void apply_patch(Doc_t *pdoc, const Node_t *patch, int &done);
+
+      static void load(Doc_t *pdoc, int fd);
+
+      template <typename tn>
+      static int write_root(tn * &ptr, Node_t *pn, const char *pad);
 
       template <typename tn>
       static int print(tn * &ptr, const char *fmt, ...);
 
       template <typename tn>
-      static int write(tn * &ptr, Node_t *pn, const char *pad = "\0", int lev = 0);
+      static int print_real(tn * &ptr, const Writer_t &wrt, double val);
+
+      template <typename tn>
+      static int write(tn * &ptr, Node_t *pn, const Writer_t &wrt, 
+            const char *pad, int lev = 0);
    };
 
    void Helper_t::free_node(Node_t * &pnode)
@@ -440,6 +1520,14 @@ namespace Icejson
             free_node(cur);
          }
       }
+      else if(Valtype::Packed == pnode->vtype)
+      {
+         drop_view(pnode);
+         if(Valtype::Float == pnode->vpacked)
+            delete [] pnode->vfloats;
+         else
+            delete [] pnode->vints;
+      }
                                 
       delete pnode;
       pnode = NULL;
@@ -447,11 +1535,96 @@ namespace Icejson
       return;
    }
 
+   void Helper_t::free_root(Doc_t *pdoc, Node_t * &pnode)
+   {
+      (void) pdoc;   /* read by the stats only */
+      STAT_DECL(Stats_t *pstats = pdoc->stats.enabled ? &pdoc->stats : NULL);
+      STAT_TIMER(pstats, free_ns, &pstats->parse_ns);
+      free_node(pnode);
+   }
+
+   /* takes member pn out of the container and frees it */
+   void Parser_t::DropMember(Node_t *pn)
+   {
+      if(pn->pprev) pn->pprev->pnext = pn->pnext;
+      else vobj = pn->pnext;
+      if(pn->pnext) pn->pnext->pprev = pn->pprev;
+
+      pcount--;
+      Helper_t::free_node(pn);
+   }
+
+   /* the three bytes get_str stores a lone surrogate as, which are not
+    * UTF-8 and so are written back as the \u escape they came from */
+   static inline bool is_surrogate(const char *str, size_t left)
+   {
+      return left >= 3 and 0xED == (unsigned char) str[0] and
+         0xA0 <= (unsigned char) str[1];
+   }
+
+   static void append_escaped(string &out, const char *str, size_t len)
+   {
+      static const char hex[] = "0123456789abcdef";
+
+      out.reserve(out.size() + len + 2);
+      out += '"';
+      for(size_t I = 0; I < len; I++)
+      {
+         /* plain runs go in one append */
+         size_t run = I;
+         while(run < len and (unsigned char) str[run] >= 0x20 and
+               '"' != str[run] and '\\' != str[run] and
+               not is_surrogate(str + run, len - run))
+            run++;
+         out.append(str + I, run - I);
+         if((I = run) == len)
+            break;
+
+         unsigned char ch = str[I];
+         switch(ch)
+         {
+            case '"'  : out += "\\\""; break;
+            case '\\' : out += "\\\\"; break;
+            case '\b' : out += "\\b"; break;
+            case '\f' : out += "\\f"; break;
+            case '\n' : out += "\\n"; break;
+            case '\r' : out += "\\r"; break;
+            case '\t' : out += "\\t"; break;
+            default   : if(ch < 0x20)
+                        {
+                           out += "\\u00";
+                           out += hex[ch >> 4];
+                           out += hex[ch & 0xF];
+                        }
+                        else
+                        {
+                           unsigned code = 0xD000 | (str[I + 1] & 0x3F) << 6 |
+                              (str[I + 2] & 0x3F);
+                           out += "\\u";
+                           for(int S = 12; S >= 0; S -= 4)
+                              out += hex[(code >> S) & 0xF];
+                           I += 2;
+                        }
+         }
+      }
+      out += '"';
+   }
+
+   /* caller buffer of the bounded write; output past end is counted
+    * but dropped and the text is always NUL terminated, as snprintf */
+   struct Bounded_t
+   {
+      char *cur;
+      char *end;
+   };
+
    template <> int Helper_t::print(FILE * &fh, const char *fmt, ...)
    {
       va_list args;
       va_start(args, fmt);
-      return vfprintf(fh, fmt, args);
+      int len = vfprintf(fh, fmt, args);
+      va_end(args);
+      return len;
    }
    
    template <> int Helper_t::print(char * &cp, const char *fmt, ...)
@@ -459,41 +1632,133 @@ namespace Icejson
       va_list args;
       va_start(args, fmt);
       int len = vsprintf(cp, fmt, args);
+      va_end(args);
       cp += len;
       return len;
    }
 
-   template <> int Helper_t::print(ostream * &os, const char *fmt, ...)
+   template <> int Helper_t::print(Bounded_t * &pb, const char *fmt, ...)
    {
       va_list args;
       va_start(args, fmt);
+      size_t room = pb->end - pb->cur;
+      int len = vsnprintf(pb->cur, room, fmt, args);
+      va_end(args);
+      if(len > 0 and room)
+         pb->cur += ((size_t) len < room) ? len : room - 1;
+      return len;
+   }
+
+   template <> int Helper_t::print(ostream * &os, const char *fmt, ...)
+   {
+      va_list args, copy;
+      va_start(args, fmt);
+      va_copy(copy, args);
       int len = vsnprintf(0, 0, fmt, args);
       if(len > 0)
       {
          string str;
+         str.resize(len + 1);
+         vsnprintf(&str[0], len + 1, fmt, copy);
          str.resize(len);
-         vsprintf(&str[0], fmt, args);
          (*os) << str;
       }
+      va_end(copy);
+      va_end(args);
+      return len;
+   }
+
+   /* NaN and the infinities as ParseOptions::NanInfinity reads them */
+   template <typename tn>
+   int Helper_t::print_real(tn * &ptr, const Writer_t &wrt, double val)
+   {
+      if(isnan(val))
+         return print(ptr, "NaN");
+      if(isinf(val))
+         return print(ptr, "%s", val < 0 ? "-Infinity" : "Infinity");
+      return print(ptr, wrt.float_format.data(), val);
+   }
+
+   /* fmt with its one conversion given the length the value is passed
+    * with, so that "%d" or "%x" prints a long long; a format holding
+    * no conversion, more than one, a '*' or a conversion of another
+    * kind is not handed to printf and deflt is used instead */
+   static string checked_format(const string &fmt, const char *convs,
+         const char *length, const char *deflt)
+   {
+      string out;
+      int count = 0;
+
+      for(size_t I = 0; I < fmt.size(); I++)
+      {
+         out += fmt[I];
+         if('%' != fmt[I])
+            continue;
+         if('%' == fmt[I + 1])
+         {
+            out += fmt[++I];
+            continue;
+         }
+
+         size_t bgn = ++I;
+         I += strspn(fmt.data() + I, "-+ #0");
+         I += strspn(fmt.data() + I, "0123456789");
+         if('.' == fmt[I])
+            I += 1 + strspn(fmt.data() + I + 1, "0123456789");
+         out.append(fmt, bgn, I - bgn);
+
+         I += strspn(fmt.data() + I, "hlLqjzt");
+         if('\0' == fmt[I] or NULL == strchr(convs, fmt[I]) or ++count > 1)
+            return deflt;
+         out += length;
+         out += fmt[I];
+      }
+
+      return 1 == count ? out : deflt;
+   }
+
+   template <typename tn>
+   int Helper_t::write_root(tn * &ptr, Node_t *pn, const char *pad)
+   {
+      static const Writer_t defaults;
+      Doc_t *pdoc = owner(pn);
+
+      STAT_DECL(Stats_t *pstats = (pdoc and pdoc->stats.enabled) ?
+            &pdoc->stats : NULL);
+      STAT_TIMER(pstats, write_ns, NULL);
+
+      Writer_t wrt;
+      if(pdoc)
+      {
+         const Writer_t &own = pdoc->writer;
+         wrt.int_format = checked_format(own.int_format, "diouxX", "ll", "%lld");
+         wrt.str_format = checked_format(own.str_format, "s", "", "%s");
+         wrt.float_format = checked_format(own.float_format, "aAeEfFgG", "", "%f");
+      }
+
+      int len = write(ptr, pn, pdoc ? wrt : defaults, pad);
+      STAT(pstats, pstats->bytes_written += len);
+
       return len;
    }
 
    template <typename tn> /* pn - pointer to node */
-   int Helper_t::write(tn * &ptr, Node_t *pn, const char *pad, int lev)
+   int Helper_t::write(tn * &ptr, Node_t *pn, const Writer_t &wrt, 
+         const char *pad, int lev)
    {
       string fmt;
+      string text;
       int len = 0;
       Node_t *itr = NULL;
-      Writer_t &wrt = pn->pdoc->writer;
 
       if(pad) for(int I = 0; I < lev; I++)
          len += print(ptr, "%s", pad);
 
       if(not pn->name.empty())
       {
-         len += print(ptr, "\"%s\"", pn->name.data());
-         if(pad) print(ptr, " : ");
-         else print(ptr, ":");
+         append_escaped(text, pn->name.data(), pn->name.size());
+         len += print(ptr, "%s", text.data());
+         len += print(ptr, pad ? " : " : ":");
       }
 
       switch(pn->vtype)
@@ -504,22 +1769,25 @@ namespace Icejson
         case Valtype::Bool : len += print(ptr, "%s", pn->vbool ? "true" : "false");
                               break;
 
-         case Valtype::Float : len += print(ptr, wrt.float_format.data(), pn->vreal); 
+         case Valtype::Float : len += print_real(ptr, wrt, pn->vreal); 
                                break;
 
          case Valtype::String :fmt  = '"'; 
                                fmt += wrt.str_format.data();
                                fmt += '"';
-                               len += print(ptr, fmt.data(), pn->vstr.data()); 
+                               text.clear();
+                               append_escaped(text, pn->vstr, pn->vlen);
+                               text.pop_back();   /* the quotes come from fmt */
+                               len += print(ptr, fmt.data(), text.data() + 1); 
                                 break;
 
          case Valtype::Array : len += print(ptr, "[");
                                if(pn->vobj)
                                {
-                                  if(pad) print(ptr, "\n");
+                                  if(pad) len += print(ptr, "\n");
                                   for(itr = pn->vobj; itr; )
                                   {
-                                     len += write(ptr, itr, pad, lev + 1);
+                                     len += write(ptr, itr, wrt, pad, lev + 1);
                                      itr  = itr->pnext;
                                      if(itr) len += print(ptr, ",");
                                      if(pad) len += print(ptr, "\n");
@@ -533,10 +1801,10 @@ namespace Icejson
          case Valtype::Object : len += print(ptr, "{");
                                 if(pn->vobj)
                                 {
-                                   if(pad) print(ptr, "\n");
+                                   if(pad) len += print(ptr, "\n");
                                    for(itr = pn->vobj; itr; )
                                    {
-                                      len += write(ptr, itr, pad, lev + 1);
+                                      len += write(ptr, itr, wrt, pad, lev + 1);
                                       itr = itr->pnext;
                                       if(itr) len += print(ptr, ",");
                                       if(pad) len += print(ptr, "\n");
@@ -547,7 +1815,21 @@ namespace Icejson
                                 len += print(ptr, "}");
                                 break;
 
+         case Valtype::Packed : len += print(ptr, "[");
+                                for(int I = 0; I < pn->pcount; I++)
+                                {
+                                   if(I) len += print(ptr, pad ? ", " : ",");
+                                   if(Valtype::Float == pn->vpacked)
+                                      len += print_real(ptr, wrt, pn->vfloats[I]);
+                                   else
+                                      len += print(ptr, wrt.int_format.data(), pn->vints[I]);
+                                }
+                                len += print(ptr, "]");
+                                break;
+
          case Valtype::Null : len += print(ptr, "null"); break;
+
+         case Valtype::Invalid : break;   /* never linked into a tree */
       }
 
       return len;
@@ -555,239 +1837,3890 @@ namespace Icejson
 }
 
 
-/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
- |        Document related implementations starts      |
- `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |      MessagePack related implementations       |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
 namespace Icejson
 {
-   Doc_t::Doc_t() {}
-
-   Node_t & Doc_t::root() { return *proot; }
-
-   Node_t & Doc_t::parse_string(const char *json_arg)
+   /* input cursor of parse_msgpack, every read is bounds checked */
+   struct Unpack_t
    {
-      Lexer_t lex;
-      Parser_t *pp = NULL; /* pointer to parser */
-
-      try
-      {
-         lex.load_string(json_arg);
+      const unsigned char *bgn;
+      const unsigned char *cur;
+      const unsigned char *end;
 
-         if(LEX_OBJECT_OPEN != lex.cur_sym)
-            trw_err("Expected object at start");
+      Intern_t *pnames;
+      Arena_t *parena;
+      Stats_t *pstats;
+      int depth;
 
-         Helper_t::free_node(proot);
-         pp = new Parser_t(this, Valtype::Object);
-         proot = pp; pp->ParseObject(lex);
+      unsigned char byte()
+      {
+         if(cur >= end)
+            trw_err("Unexpected end of data");
+         return *cur++;
+      }
 
-         return *proot;
+      uint64_t uint(int len)   /* big endian */
+      {
+         if(end - cur < len)
+            trw_err("Unexpected end of data");
+         uint64_t val = 0;
+         for(int I = 0; I < len; I++)
+            val = (val << 8) | *cur++;
+         return val;
       }
-      catch(Exception exc)
+
+      const char * bytes(uint64_t len)
       {
-         error.desc = exc.msg;
-         error.line = lex.line;
-         error.colum = lex.cur_pos - lex.line_bgn + 1;
-         error.offset = lex.cur_pos - lex.json_str + 1;
-         Helper_t::free_node(proot);
+         if((uint64_t) (end - cur) < len)
+            trw_err("Unexpected end of data");
+         const char *ptr = (const char *) cur;
+         cur += len;
+         return ptr;
       }
+   };
 
-      return oInvalid;
+   static void pack_uint(string &out, unsigned char tag, uint64_t val, int len)
+   {
+      out += (char) tag;
+      for(int I = len - 1; I >= 0; I--)
+         out += (char) (val >> (8 * I));
    }
 
-   Node_t & Doc_t::parse_file(FILE *fh)
+   static void pack_int(string &out, long long val)
    {
-      struct stat st;
-      char *json_str = NULL;
-      fstat(fileno(fh), &st);
-      json_str = new char [st.st_size];
-      fread(json_str, sizeof(char), st.st_size, fh);
-      Node_t &root = parse_string(json_str);
-      delete [] json_str;
-      return root;
+      if(0 <= val and val < 128)
+         out += (char) val;
+      else if(-32 <= val and val < 0)
+         out += (char) (0xE0 | (val + 32));
+      else if(-128 <= val and val < 128)
+         pack_uint(out, 0xD0, val, 1);
+      else if(-32768 <= val and val < 32768)
+         pack_uint(out, 0xD1, val, 2);
+      else if(-2147483648LL <= val and val < 2147483648LL)
+         pack_uint(out, 0xD2, val, 4);
+      else
+         pack_uint(out, 0xD3, val, 8);
    }
 
-   Node_t & Doc_t::parse_file(const char *file_path)
+   static void pack_float(string &out, double val)
+   {
+      uint64_t bits;
+      memcpy(&bits, &val, 8);
+      pack_uint(out, 0xCB, bits, 8);
+   }
+
+   static void pack_str(string &out, const char *str, size_t len)
+   {
+      if(len < 32)
+         out += (char) (0xA0 | len);
+      else if(len < 0x100)
+         pack_uint(out, 0xD9, len, 1);
+      else if(len < 0x10000)
+         pack_uint(out, 0xDA, len, 2);
+      else
+         pack_uint(out, 0xDB, len, 4);
+      out.append(str, len);
+   }
+
+   static void pack_head(string &out, int count, bool map)
+   {
+      if(count < 16)
+         out += (char) ((map ? 0x80 : 0x90) | count);
+      else if(count < 0x10000)
+         pack_uint(out, map ? 0xDE : 0xDC, count, 2);
+      else
+         pack_uint(out, map ? 0xDF : 0xDD, count, 4);
+   }
+
+   void Helper_t::pack(string &out, Node_t *pn)
+   {
+      switch(pn->vtype)
+      {
+         case Valtype::Int    : pack_int(out, pn->vint);
+                                break;
+
+         case Valtype::Float  : pack_float(out, pn->vreal);
+                                break;
+
+         case Valtype::String : pack_str(out, pn->vstr, pn->vlen);
+                                break;
+
+         case Valtype::Bool   : out += (char) (pn->vbool ? 0xC3 : 0xC2);
+                                break;
+
+         case Valtype::Packed : pack_head(out, pn->pcount, false);
+                                for(int I = 0; I < pn->pcount; I++)
+                                   if(Valtype::Float == pn->vpacked)
+                                      pack_float(out, pn->vfloats[I]);
+                                   else
+                                      pack_int(out, pn->vints[I]);
+                                break;
+
+         case Valtype::Array  : pack_head(out, pn->pcount, false);
+                                for(Node_t *itr = pn->vobj; itr; itr = itr->pnext)
+                                   pack(out, itr);
+                                break;
+
+         case Valtype::Object : pack_head(out, pn->pcount, true);
+                                for(Node_t *itr = pn->vobj; itr; itr = itr->pnext)
+                                {
+                                   pack_str(out, itr->name.data(), itr->name.size());
+                                   pack(out, itr);
+                                }
+                                break;
+
+         default              : out += (char) 0xC0;   /* null */
+      }
+   }
+
+   bool Parser_t::UnpackNode(Unpack_t &in)
+   {
+      unsigned char tag = in.byte();
+      uint64_t count = 0;
+      uint64_t len = 0;
+      bool map = false;
+
+      if(tag < 0x80)
+      {
+         vint = tag;
+         vtype = Valtype::Int;
+      }
+      else if(tag >= 0xE0)
+      {
+         vint = (signed char) tag;
+         vtype = Valtype::Int;
+      }
+      else if(0xA0 == (tag & 0xE0) or (0xD9 <= tag and tag <= 0xDB))
+      {
+         len = (tag < 0xC0) ? (tag & 0x1F) : in.uint(1 << (tag - 0xD9));
+         if(len > INT32_MAX)
+            trw_err("String too long");
+         vlen = len;
+         vstr = in.parena->copy(in.bytes(len), len);
+         vtype = Valtype::String;
+      }
+      else if(0x80 == (tag & 0xF0) or 0xDE == tag or 0xDF == tag)
+      {
+         map = true;
+         count = (tag < 0x90) ? (tag & 0x0F) : in.uint(0xDE == tag ? 2 : 4);
+      }
+      else if(0x90 == (tag & 0xF0) or 0xDC == tag or 0xDD == tag)
+      {
+         count = (tag < 0xA0) ? (tag & 0x0F) : in.uint(0xDC == tag ? 2 : 4);
+      }
+      else switch(tag)
+      {
+         case 0xC0 : vtype = Valtype::Null;  break;
+         case 0xC2 : vtype = Valtype::Bool; vbool = false; break;
+         case 0xC3 : vtype = Valtype::Bool; vbool = true;  break;
+
+         case 0xCC : case 0xCD : case 0xCE : case 0xCF :
+                     len = in.uint(1 << (tag - 0xCC));
+                     if(len > (uint64_t) INT64_MAX)
+                     {
+                        vreal = len;   /* too big for a long long */
+                        vtype = Valtype::Float;
+                     }
+                     else
+                     {
+                        vint = len;
+                        vtype = Valtype::Int;
+                     }
+                     break;
+
+         case 0xD0 : vint = (int8_t) in.uint(1);  vtype = Valtype::Int; break;
+         case 0xD1 : vint = (int16_t) in.uint(2); vtype = Valtype::Int; break;
+         case 0xD2 : vint = (int32_t) in.uint(4); vtype = Valtype::Int; break;
+         case 0xD3 : vint = (int64_t) in.uint(8); vtype = Valtype::Int; break;
+
+         case 0xCA : { uint32_t bits = in.uint(4);
+                       float val;
+                       memcpy(&val, &bits, 4);
+                       vreal = val;
+                       vtype = Valtype::Float;
+                       break; }
+
+         case 0xCB : { uint64_t bits = in.uint(8);
+                       memcpy(&vreal, &bits, 8);
+                       vtype = Valtype::Float;
+                       break; }
+
+         default   : trw_err("Unsupported MessagePack type");
+      }
+
+      if(0x80 == (tag & 0xE0) or (0xDC <= tag and tag <= 0xDF))
+      {
+         /* every element takes at least one byte */
+         if(count > (uint64_t) (in.end - in.cur))
+            trw_err("Unexpected end of data");
+         if(++in.depth > Lexer_t::MaxDepth)
+            trw_err("Nesting too deep");
+
+         vtype = map ? Valtype::Object : Valtype::Array;
+         Parser_t *pp = NULL;
+         for(uint64_t I = 0; I < count; I++)
+         {
+            Parser_t *child = new Parser_t(pdoc);
+            child->pparent = this;
+            child->pprev = pp;
+            if(pp) pp->pnext = child;
+            else vobj = child;
+            vlast = pp = child;
+            pcount++;
+
+            if(map)
+            {
+               tag = in.byte();
+               if(0xA0 == (tag & 0xE0))
+                  len = tag & 0x1F;
+               else if(0xD9 <= tag and tag <= 0xDB)
+                  len = in.uint(1 << (tag - 0xD9));
+               else
+                  trw_err("Expected string key");
+               child->name.psym = in.pnames->intern(in.bytes(len), len);
+            }
+
+            child->UnpackNode(in);
+         }
+         in.depth--;
+      }
+
+      STAT(in.pstats, CountNode(*in.pstats, this));
+
+      return OK;
+   }
+
+   int Node_t::write_msgpack(string &out)
+   {
+      size_t len = out.size();
+      Helper_t::pack(out, this);
+      return out.size() - len;
+   }
+
+   Node_t & Doc_t::parse_msgpack(const char *data, size_t len)
+   {
+      Unpack_t in;
+      in.bgn = in.cur = (const unsigned char *) data;
+      in.end = in.bgn + len;
+      in.pstats = stats.enabled ? &stats : NULL;
+      in.depth = 0;
+
+      try
+      {
+         reset();
+         in.pnames = &names();
+         in.parena = parena;
+
+         unsigned char tag = len ? *in.cur : 0;
+         if(0x80 != (tag & 0xF0) and 0xDE != tag and 0xDF != tag)
+            trw_err("Expected object at start");
+
+         Parser_t *pp = new Parser_t(this);
+         proot = pp; pp->UnpackNode(in);
+
+         if(in.cur != in.end)
+            trw_err("Unexpected data after root value");
+
+         STAT(in.pstats, in.pstats->bytes += len);
+
+         return *proot;
+      }
+      catch(Exception exc)
+      {
+         error.desc = exc.msg;
+         error.line = 0;
+         error.colum = error.offset = in.cur - in.bgn + 1;
+         Helper_t::free_node(proot);
+      }
+
+      return oInvalid;
+   }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |        Document related implementations starts      |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+namespace Icejson
+{
+   Doc_t::Doc_t()
+   {
+      proot = NULL;
+      psnap = NULL;
+      intern = NULL;
+      pnames = NULL;
+      pack_numbers = false;
+      options = ParseOptions::Strict;
+      parena = new Arena_t;
+      pviews = new Views_t;
+   }
+
+   /* drops the tree along with its strings; its own names are kept
+    * for the next parse unless there are too many of them */
+   void Doc_t::reset()
+   {
+      pviews->clear();
+      if(psnap)
+      {
+         Helper_t::unmap_image(psnap);
+         psnap = NULL;
+         proot = NULL;
+      }
+      else Helper_t::free_root(this, proot);
+
+      if(pnames and not intern and pnames->size() > KeepNames)
+         pnames->clear();   /* no node refers to it any more */
+      parena->clear();
+   }
+
+   Intern_t & Doc_t::names()
+   {
+      if(intern) return *intern;
+      if(NULL == pnames) pnames = new Intern_t(false);
+      return *pnames;
+   }
+
+   Node_t & Doc_t::root() { return *proot; }
+
+   /* instances of Parser_t::ParseRoot by the ParseOptions they take */
+   typedef void (Parser_t::*ParseRoot_t)(Lexer_t &lex, bool any_root);
+
+   static const ParseRoot_t parse_root[] =
+   {
+      &Parser_t::ParseRoot<0>, &Parser_t::ParseRoot<1>,
+      &Parser_t::ParseRoot<2>, &Parser_t::ParseRoot<3>,
+      &Parser_t::ParseRoot<4>, &Parser_t::ParseRoot<5>,
+      &Parser_t::ParseRoot<6>, &Parser_t::ParseRoot<7>
+   };
+
+   typedef void (Parser_t::*ProjectRoot_t)(Lexer_t &lex, const Step_t *step, bool any_root);
+
+   static const ProjectRoot_t project_root[] =
+   {
+      &Parser_t::ProjectRoot<0>, &Parser_t::ProjectRoot<1>,
+      &Parser_t::ProjectRoot<2>, &Parser_t::ProjectRoot<3>,
+      &Parser_t::ProjectRoot<4>, &Parser_t::ProjectRoot<5>,
+      &Parser_t::ProjectRoot<6>, &Parser_t::ProjectRoot<7>
+   };
+
+   Node_t & Doc_t::parse_string(const char *json_arg)
+   {
+      return parse(json_arg, NULL);
+   }
+
+   Node_t & Doc_t::parse_string(const char *json_str, const Projection_t &proj)
+   {
+      return parse(json_str, proj.ptop);
+   }
+
+#ifdef ICEJSON_STATS
+   /* the lexer alone over text that parsed, no nodes built, timed into
+    * lex_ns and taken off parse_ns which is still running */
+   static void lex_only(Stats_t *pstats, const char *json_arg, int options)
+   {
+      Lap_t lap(&pstats->lex_ns, &pstats->parse_ns);
+      Lexer_t lex;
+      lex.options = options;
+
+      try
+      {
+         lex.load_string(json_arg);
+         lex.skip_value();
+      }
+      catch(Exception exc) {}
+   }
+#endif
+
+   /* whole tree when pstep is NULL, its projection otherwise */
+   Node_t & Doc_t::parse(const char *json_arg, const Step_t *pstep)
+   {
+      Lexer_t lex;
+      Parser_t *pp = NULL; /* pointer to parser */
+
+      STAT_DECL(Stats_t *pstats = stats.enabled ? &stats : NULL);
+      STAT(pstats, lex.pstats = pstats);
+
+      try
+      {
+         STAT_TIMER(pstats, parse_ns, NULL);
+
+         reset();
+         lex.pnames = &names();
+         lex.parena = parena;
+         lex.options = options;
+
+         lex.load_string(json_arg);
+
+         pp = new Parser_t(this);
+         proot = pp; 
+
+         int shape = options & (ParseOptions::TrailingCommas | ParseOptions::DupPolicy);
+         if(pstep)
+         {
+            ProjectRoot_t root = project_root[shape];
+            (pp->*root)(lex, pstep, options & ParseOptions::AnyRoot);
+         }
+         else
+         {
+            ParseRoot_t root = parse_root[shape];
+            (pp->*root)(lex, options & ParseOptions::AnyRoot);
+         }
+
+         STAT(pstats, Parser_t::CountNode(*pstats, proot);
+                      pstats->bytes += lex.json_end - lex.json_str;
+                      lex_only(pstats, json_arg, options));
+
+         return *proot;
+      }
+      catch(Exception exc)
+      {
+         error.desc = exc.msg;
+         error.line = lex.line;
+         error.colum = lex.cur_pos - lex.line_bgn + 1;
+         error.offset = lex.cur_pos - lex.json_str + 1;
+         Helper_t::free_node(proot);
+      }
+
+      return oInvalid;
+   }
+
+   /* reads fh to its end, the size from fstat is only a first guess
+    * as pipes have none and a file may grow while it is read */
+   Node_t & Doc_t::parse_file(FILE *fh)
+   {
+      struct stat st;
+      size_t cap = 1 << 16;
+      if(0 == fstat(fileno(fh), &st) and S_ISREG(st.st_mode))
+         cap = st.st_size + 1;   /* one more to see the end at once */
+
+      char *json_str = (char *) malloc(cap + 1);
+      size_t len = 0;
+
+      while(json_str)
+      {
+         len += fread(json_str + len, sizeof(char), cap - len, fh);
+         if(len < cap)
+            break;
+
+         cap *= 2;
+         char *big = (char *) realloc(json_str, cap + 1);
+         if(NULL == big) break;
+         json_str = big;
+      }
+
+      if(NULL == json_str or len == cap or ferror(fh))
+      {
+         free(json_str);
+         reset();
+         error.desc = "Unable to read file";
+         error.line = error.colum = error.offset = 0;
+         return oInvalid;
+      }
+
+      json_str[len] = '\0';
+      Node_t &root = parse_string(json_str);
+      free(json_str);
+      return root;
+   }
+
+   Node_t & Doc_t::parse_file(const char *file_path)
    {
       FILE *fh = fopen(file_path, "r");
-      if(NULL == fh) return oInvalid;
+      if(NULL == fh)
+      {
+         reset();
+         error.desc = "Unable to open file";
+         error.line = error.colum = error.offset = 0;
+         return oInvalid;
+      }
       Node_t &root = parse_file(fh);
       fclose(fh);
       return root;
    }
 
-   Doc_t::~Doc_t()
+   Doc_t::~Doc_t()
+   {
+      reset();
+      delete pnames;
+      delete parena;
+      delete pviews;
+   }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |     Projection related implementations         |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+namespace Icejson
+{
+   Projection_t::Projection_t() : ptop(new Step_t) {}
+
+   Projection_t::~Projection_t() { delete ptop; }
+
+   Step_t::~Step_t()
+   {
+      for(size_t I = 0; I < members.size(); I++)
+         delete members[I].second;
+      for(size_t I = 0; I < items.size(); I++)
+         delete items[I].second;
+      delete pall;
+   }
+
+   /* the path is split and checked before anything is added, so a
+    * malformed one leaves the projection as it was */
+   bool Projection_t::add(const char *path)
+   {
+      vector<pair<string, int> > keys;   /* index -1 for a member, -2 for [*] */
+      const char *cur = path;
+
+      for(bool first = true; '\0' != *cur; first = false)
+      {
+         if('[' == *cur)
+         {
+            int idx = -2;
+            if('*' == *++cur)
+               cur++;
+            else
+            {
+               size_t len = strspn(cur, "0123456789");
+               if(0 == len or len > 9)
+                  return false;
+               idx = atoi(cur);
+               cur += len;
+            }
+            if(']' != *cur++)
+               return false;
+            keys.push_back(make_pair(string(), idx));
+            continue;
+         }
+
+         if(not first and '.' != *cur++)
+            return false;
+
+         size_t len = strcspn(cur, ".[");
+         if(0 == len)
+            return false;
+         keys.push_back(make_pair(string(cur, len), -1));
+         cur += len;
+      }
+
+      if(keys.empty())
+         return false;
+
+      Step_t *step = ptop;
+      for(size_t I = 0; I < keys.size() and not step->whole; I++)
+      {
+         Step_t *next = NULL;
+         int idx = keys[I].second;
+
+         if(-1 == idx)
+         {
+            next = (Step_t *) step->member(keys[I].first.data(), keys[I].first.size());
+            if(NULL == next)
+            {
+               next = new Step_t;
+               step->members.push_back(make_pair(keys[I].first, next));
+            }
+         }
+         else if(-2 == idx)
+         {
+            if(NULL == step->pall)
+               step->pall = new Step_t;
+            next = step->pall;
+         }
+         else
+         {
+            for(size_t J = 0; J < step->items.size() and NULL == next; J++)
+               if(idx == step->items[J].first)
+                  next = step->items[J].second;
+            if(NULL == next)
+            {
+               next = new Step_t;
+               step->items.push_back(make_pair(idx, next));
+            }
+         }
+
+         step = next;
+      }
+
+      step->whole = true;
+
+      return OK;
+   }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |       Writer realted implementation            |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+namespace Icejson
+{
+   Writer_t::Writer_t() 
+   {
+      int_format = "%lld";
+      str_format = "%s";
+      float_format = "%f";
+   }
+
+   int Node_t::write(FILE *fh, const char *pad)
+   {
+      return Helper_t::write_root(fh, this, pad);
+   }
+   
+   int Node_t::write(char *str, const char *pad)
+   {
+      return Helper_t::write_root(str, this, pad);
+   }
+
+   int Node_t::write(char *str, size_t size, const char *pad)
+   {
+      Bounded_t buf = { str, str + size };
+      Bounded_t *pbuf = &buf;
+      if(size) *str = '\0';
+      return Helper_t::write_root(pbuf, this, pad);
+   }
+
+   int Node_t::write(ostream &os, const char *pad)
+   {
+      ostream *pos = &os;
+      return Helper_t::write_root(pos, this, pad);
+   }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |       Stats related implementations starts     |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+namespace Icejson
+{
+   Stats_t::Stats_t()
+   {
+      enabled = false;
+      reset();
+   }
+
+   void Stats_t::reset()
+   {
+      bytes = bytes_written = bytes_allocated = 0;
+      ints = floats = strings = bools = nulls = arrays = objects = 0;
+      strings_copied = escapes = 0;
+      max_depth = 0;
+      tokens = 0;
+      parse_ns = lex_ns = free_ns = write_ns = 0;
+   }
+
+   Node_t & Stats_t::export_doc(Doc_t &doc) const
+   {
+      char json_str[1024];
+      snprintf(json_str, sizeof json_str,
+            "{ \"bytes\" : %lld, \"bytes_written\" : %lld, "
+            "\"bytes_allocated\" : %lld, "
+            "\"nodes\" : { \"int\" : %lld, \"float\" : %lld, "
+            "\"string\" : %lld, \"bool\" : %lld, \"null\" : %lld, "
+            "\"array\" : %lld, \"object\" : %lld }, "
+            "\"strings_copied\" : %lld, "
+            "\"escapes\" : %lld, \"max_depth\" : %d, \"tokens\" : %lld, "
+            "\"time_ns\" : { \"parse\" : %lld, \"lex\" : %lld, \"build\" : %lld, "
+            "\"teardown\" : %lld, \"write\" : %lld } }",
+            bytes, bytes_written, bytes_allocated,
+            ints, floats, strings, bools, nulls, arrays, objects,
+            strings_copied, escapes, max_depth, tokens,
+            parse_ns, lex_ns, max(0LL, parse_ns - lex_ns), free_ns, write_ns);
+      return doc.parse_string(json_str);
+   }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |       Intern related implementations starts    |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+namespace Icejson
+{
+   /* high and low half of the full product folded together */
+   static inline uint64_t mum(uint64_t lhs, uint64_t rhs)
+   {
+      __uint128_t val = (__uint128_t) lhs * rhs;
+      return (uint64_t) val ^ (uint64_t) (val >> 64);
+   }
+
+   /* 64 bit hash of a byte string in the manner of wyhash, 16 bytes
+    * a round and the tail read as two words that may overlap; names
+    * keep theirs in Sym_t::hash, which the structural hashes reuse */
+   static uint64_t hash_text(const char *str, size_t len)
+   {
+      const uint64_t k0 = 0xA0761D6478BD642FULL;
+      const uint64_t k1 = 0xE7037ED1A0B428DBULL;
+
+      uint64_t sum = mum(len ^ k0, k1);
+      uint64_t lo = 0, hi = 0;
+      size_t left = len;
+
+      for( ; left > 16; str += 16, left -= 16)
+      {
+         memcpy(&lo, str, 8);
+         memcpy(&hi, str + 8, 8);
+         sum = mum(lo ^ k1, hi ^ sum);
+      }
+
+      lo = hi = 0;
+      if(left > 8)
+      {
+         memcpy(&lo, str, 8);
+         memcpy(&hi, str + left - 8, 8);
+      }
+      else
+         memcpy(&lo, str, left);
+
+      return mum(mum(lo ^ k1, hi ^ sum) ^ k0, len ^ k1);
+   }
+
+   /* open addressing table, probed without locks; a grown table
+    * replaces the old one which is kept for readers still in it */
+   struct Table_t
+   {
+      unsigned mask;
+      int count;
+      atomic<const Sym_t *> *slots;
+
+      Table_t(unsigned size) : mask(size - 1), count(0)
+      {
+         slots = new atomic<const Sym_t *> [size];
+         for(unsigned I = 0; I < size; I++)
+            slots[I].store(NULL, memory_order_relaxed);
+      }
+
+      ~Table_t() { delete [] slots; }
+
+      const Sym_t * find(const char *str, int len, uint64_t hash) const
+      {
+         for(unsigned I = hash & mask; ; I = (I + 1) & mask)
+         {
+            const Sym_t *sym = slots[I].load(memory_order_acquire);
+            if(NULL == sym)
+               return NULL;
+            if(hash == sym->hash and len == sym->len and
+                  0 == memcmp(str, sym->str, len))
+               return sym;
+         }
+      }
+
+      void insert(const Sym_t *sym)
+      {
+         unsigned I = sym->hash & mask;
+         while(slots[I].load(memory_order_relaxed))
+            I = (I + 1) & mask;
+         slots[I].store(sym, memory_order_release);
+         count++;
+      }
+   };
+
+   struct Intern_t::Shard_t
+   {
+      mutex mtx;   /* taken by writers only */
+      atomic<Table_t *> table;
+      vector<Table_t *> retired;
+      vector<char *> chunks;
+      size_t used;
+
+      enum { ChunkSize = 16 * 1024 };
+
+      Shard_t() : table(new Table_t(64)), used(ChunkSize) {}
+
+      ~Shard_t() { clear(); delete table.load(); }
+
+      Sym_t * alloc(int len)
+      {
+         size_t size = (offsetof(Sym_t, str) + len + 1 + 7) & ~(size_t) 7;
+         if(size > ChunkSize)
+         {
+            chunks.insert(chunks.begin(), new char [size]);
+            return (Sym_t *) chunks.front();
+         }
+         if(used + size > ChunkSize)
+         {
+            chunks.push_back(new char [ChunkSize]);
+            used = 0;
+         }
+         Sym_t *sym = (Sym_t *) (chunks.back() + used);
+         used += size;
+         return sym;
+      }
+
+      void clear()
+      {
+         for(size_t I = 0; I < chunks.size(); I++)
+            delete [] chunks[I];
+         for(size_t I = 0; I < retired.size(); I++)
+            delete retired[I];
+         chunks.clear();
+         retired.clear();
+         used = ChunkSize;
+      }
+   };
+
+   Intern_t::Intern_t(bool shared) : shared(shared), next_id(0)
+   {
+      nshards = shared ? 16 : 1;
+      shards = new Shard_t [nshards];
+   }
+
+   const Sym_t * Intern_t::find(const char *str, int len) const
+   {
+      uint64_t hash = hash_text(str, len);
+      Shard_t &shd = shards[(hash >> 56) % nshards];
+      return shd.table.load(memory_order_acquire)->find(str, len, hash);
+   }
+
+   const Sym_t * Intern_t::intern(const char *str, int len)
+   {
+      uint64_t hash = hash_text(str, len);
+      Shard_t &shd = shards[(hash >> 56) % nshards];
+
+      const Sym_t *sym = shd.table.load(memory_order_acquire)->find(str, len, hash);
+      if(sym) return sym;
+
+      unique_lock<mutex> lck(shd.mtx, defer_lock);
+      if(shared) lck.lock();
+
+      /* someone may have added it while we waited for the lock */
+      Table_t *tbl = shd.table.load(memory_order_relaxed);
+      if((sym = tbl->find(str, len, hash)))
+         return sym;
+
+      Sym_t *nsym = shd.alloc(len);
+      nsym->id = next_id++;
+      nsym->len = len;
+      nsym->hash = hash;
+      memcpy(nsym->str, str, len);
+      nsym->str[len] = '\0';
+
+      if(2 * (tbl->count + 1) > (int) tbl->mask + 1)
+      {
+         Table_t *grown = new Table_t(2 * (tbl->mask + 1));
+         for(unsigned I = 0; I <= tbl->mask; I++)
+            if(const Sym_t *old = tbl->slots[I].load(memory_order_relaxed))
+               grown->insert(old);
+         grown->insert(nsym);
+         shd.table.store(grown, memory_order_release);
+         shd.retired.push_back(tbl);
+      }
+      else tbl->insert(nsym);
+
+      return nsym;
+   }
+
+   int Intern_t::size() const { return next_id.load(); }
+
+   void Intern_t::clear()
+   {
+      for(int I = 0; I < nshards; I++)
+      {
+         /* the slots stay as large as they grew, for the names to come */
+         Shard_t &shd = shards[I];
+         shd.clear();
+         Table_t *tbl = shd.table.load(memory_order_relaxed);
+         for(unsigned J = 0; J <= tbl->mask; J++)
+            tbl->slots[J].store(NULL, memory_order_relaxed);
+         tbl->count = 0;
+      }
+      next_id = 0;
+   }
+
+   Intern_t::~Intern_t() { delete [] shards; }
+
+   bool Name_t::operator == (const Name_t &rhs) const
+   {
+      if(psym == rhs.psym) return true;
+      return size() == rhs.size() and 0 == memcmp(data(), rhs.data(), size());
+   }
+
+   bool Name_t::operator == (const string &str) const
+   {
+      return (int) str.size() == size() and 0 == memcmp(data(), str.data(), size());
+   }
+
+   bool Name_t::operator == (const char *str) const
+   {
+      return 0 == strcmp(data(), str);
+   }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |      Snapshot related implementations starts   |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+namespace Icejson
+{
+   /* header of a snapshot image, which holds the nodes followed by
+    * the name index, the names, the packed arrays and the strings;
+    * pointers in the image are valid when it is mapped at base and
+    * are all off by the same delta when it is mapped elsewhere */
+   struct Image_t
+   {
+      char magic[8];
+      uint32_t version;
+      uint32_t node_size;   /* sizeof(Node_t) of the writer */
+      uint64_t base;
+      uint64_t size;        /* of the whole image */
+      uint64_t count;       /* nodes, the root is the first */
+      uint64_t nodes;       /* offsets from the start of the image */
+      uint64_t index;       /* open addressing table of name offsets */
+      uint64_t slots;       /* power of two */
+      uint64_t names;
+      uint64_t packed;
+      uint64_t strings;     /* up to size */
+   };
+
+   enum { SnapVersion = 4, MaxSnapshots = 64 };
+
+   /* nodes of an image are never constructed, the mapping provides
+    * them the way memcpy would, which holds only while Node_t can be
+    * copied and dropped as plain bytes */
+   static_assert(is_trivially_copyable<Node_t>::value and
+         is_trivially_destructible<Node_t>::value,
+         "snapshot nodes are used as mapped");
+
+   static const char snap_magic[8] = { 'I', 'C', 'E', 'S', 'N', 'A', 'P', 0 };
+
+   struct Snapshot_t
+   {
+      const char *base;
+      size_t size;
+      Doc_t *pdoc;
+      Node_t *proot;
+      const uint64_t *index;
+      uint64_t mask;
+   };
+
+   /* sizes gathered by a first walk over the tree being saved and
+    * the cursors of the second walk writing it into the image */
+   struct Layout_t
+   {
+      Layout_t() : count(0), names(0), packed(0), strings(0) {}
+
+      uint64_t count;
+      uint64_t names;
+      uint64_t packed;
+      uint64_t strings;
+      unordered_map<const Sym_t *, uint64_t> syms;  /* to image offset */
+
+      char *img;
+      uint64_t base;
+      Node_t *nodes;
+      char *pk;         /* next packed array */
+      char *st;         /* next string */
+      uint64_t next;    /* next free node */
+
+      /* address ptr in the image will have once mapped at base */
+      template <typename tn>
+      tn * at(const void *ptr) const
+      {
+         return (tn *) (base + ((const char *) ptr - img));
+      }
+   };
+
+   /* mapped images by address range, nodes in an image carry no
+    * document pointer so their document is found from their address */
+   static atomic<Snapshot_t *> snapshots[MaxSnapshots];
+
+   static uint64_t sym_size(int len)
+   {
+      return (offsetof(Sym_t, str) + len + 1 + 7) & ~(uint64_t) 7;
+   }
+
+   /* preferred address of a new image, away from where heaps and
+    * libraries usually go and picked per image so that several
+    * snapshots rarely ask for the same range */
+   static uint64_t image_base()
+   {
+      uint64_t seed = chrono::steady_clock::now().time_since_epoch().count();
+      seed = (seed ^ ((uint64_t) getpid() << 32)) * 0xBF58476D1CE4E5B9ULL;
+      return 0x200000000000ULL + ((seed >> 40) % 0x1000) * 0x100000000ULL;
+   }
+
+   template <typename tn>
+   static void move_ptr(tn * &ptr, intptr_t delta)
+   {
+      if(ptr) ptr = (tn *) ((const char *) ptr + delta);
+   }
+
+   Doc_t * Helper_t::owner(const Node_t *pn)
+   {
+      if(NULL == pn) return NULL;
+      if(pn->pdoc) return pn->pdoc;
+
+      const char *ptr = (const char *) pn;
+      for(int I = 0; I < MaxSnapshots; I++)
+      {
+         Snapshot_t *ps = snapshots[I].load(memory_order_acquire);
+         if(ps and ps->base <= ptr and ptr < ps->base + ps->size)
+            return ps->pdoc;
+      }
+
+      return NULL;
+   }
+
+   const Sym_t * Helper_t::find_name(Doc_t *pdoc, const char *str, int len)
+   {
+      if(NULL == pdoc)
+         return NULL;
+
+      Snapshot_t *ps = pdoc->psnap;
+      if(NULL == ps)
+         return pdoc->names().find(str, len);
+
+      uint64_t hash = hash_text(str, len);
+      for(uint64_t I = hash & ps->mask; ps->index[I]; I = (I + 1) & ps->mask)
+      {
+         const Sym_t *sym = (const Sym_t *) (ps->base + ps->index[I]);
+         if(hash == sym->hash and len == sym->len and
+               0 == memcmp(str, sym->str, len))
+            return sym;
+      }
+
+      return NULL;
+   }
+
+   void Helper_t::measure(Node_t *pn, Layout_t &lay)
+   {
+      lay.count++;
+
+      const Sym_t *sym = pn->name.sym();
+      if(sym and lay.syms.insert(make_pair(sym, 0)).second)
+         lay.names += sym_size(sym->len);
+
+      switch(pn->vtype)
+      {
+         case Valtype::String : lay.strings += pn->vlen + 1;
+                                break;
+
+         case Valtype::Packed : lay.packed += pn->pcount * 8;
+                                break;
+
+         case Valtype::Array  :
+         case Valtype::Object : for(Node_t *itr = pn->vobj; itr; itr = itr->pnext)
+                                   measure(itr, lay);
+                                break;
+
+         default              : break;
+      }
+   }
+
+   /* the children of a container are adjacent and the containers are
+    * laid out depth first, so a subtree stays close together */
+   void Helper_t::place(Layout_t &lay, Node_t &dst, const Node_t *src)
+   {
+      dst.vtype = src->vtype;
+      dst.pcount = src->pcount;
+      dst.vhash = src->vhash;
+
+      switch(src->vtype)
+      {
+         case Valtype::String : memcpy(lay.st, src->vstr, src->vlen + 1);
+                                dst.vstr = lay.at<const char>(lay.st);
+                                dst.vlen = src->vlen;
+                                lay.st += src->vlen + 1;
+                                break;
+
+         case Valtype::Packed : memcpy(lay.pk, src->vints, src->pcount * 8);
+                                dst.vints = lay.at<long long>(lay.pk);
+                                dst.vpacked = src->vpacked;
+                                lay.pk += src->pcount * 8;
+                                break;
+
+         case Valtype::Array  :
+         case Valtype::Object : if(src->vobj)
+                                {
+                                   Node_t *kids = lay.nodes + lay.next;
+                                   Node_t *kid = kids;
+                                   for(Node_t *itr = src->vobj; itr; itr = itr->pnext, kid++)
+                                   {
+                                      kid->pparent = lay.at<Node_t>(&dst);
+                                      if(itr->pprev) kid->pprev = lay.at<Node_t>(kid - 1);
+                                      if(itr->pnext) kid->pnext = lay.at<Node_t>(kid + 1);
+                                      if(itr->name.sym())
+                                         kid->name.psym = lay.at<const Sym_t>(
+                                               lay.img + lay.syms[itr->name.sym()]);
+                                   }
+                                   lay.next += kid - kids;
+                                   dst.vobj = lay.at<Node_t>(kids);
+                                   dst.vlast = lay.at<Node_t>(kid - 1);
+
+                                   kid = kids;
+                                   for(Node_t *itr = src->vobj; itr; itr = itr->pnext)
+                                      place(lay, *kid++, itr);
+                                }
+                                break;
+
+         default              : dst.vint = src->vint;  /* all of the scalar */
+                                break;
+      }
+   }
+
+   void Helper_t::save_image(const char *file_path, Node_t *root)
+   {
+      Layout_t lay;
+      measure(root, lay);
+
+      uint64_t slots = 8;
+      while(slots < 2 * lay.syms.size())
+         slots *= 2;
+
+      Image_t hdr;
+      memset(&hdr, 0, sizeof hdr);
+      hdr.version = SnapVersion;
+      hdr.node_size = sizeof(Node_t);
+      hdr.base = image_base();
+      hdr.count = lay.count;
+      hdr.nodes = (sizeof hdr + 63) & ~(uint64_t) 63;
+      hdr.index = hdr.nodes + hdr.count * sizeof(Node_t);
+      hdr.slots = slots;
+      hdr.names = hdr.index + slots * sizeof(uint64_t);
+      hdr.packed = hdr.names + lay.names;
+      hdr.strings = hdr.packed + lay.packed;
+      hdr.size = hdr.strings + lay.strings;
+
+      uint64_t names = hdr.names;
+
+      /* written aside and renamed over file_path, so processes which
+       * have the old image mapped keep it intact */
+      string tmp_path = string(file_path) + ".tmp";
+      int fd = open(tmp_path.data(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+      if(fd < 0)
+         trw_err("Unable to create snapshot");
+
+      char *img = (char *) MAP_FAILED;
+      if(0 == ftruncate(fd, hdr.size))
+         img = (char *) mmap(NULL, hdr.size, PROT_READ | PROT_WRITE,
+               MAP_SHARED, fd, 0);
+      close(fd);
+      if(MAP_FAILED == img)
+      {
+         unlink(tmp_path.data());
+         trw_err("Unable to write snapshot");
+      }
+
+      int id = 0;
+      uint64_t *index = (uint64_t *) (img + hdr.index);
+      for(auto &ent : lay.syms)
+      {
+         const Sym_t *sym = ent.first;
+         Sym_t *dst = (Sym_t *) (img + names);
+         dst->id = id++;
+         dst->len = sym->len;
+         dst->hash = sym->hash;
+         memcpy(dst->str, sym->str, sym->len + 1);
+
+         uint64_t I = sym->hash & (slots - 1);
+         while(index[I])
+            I = (I + 1) & (slots - 1);
+         index[I] = ent.second = names;
+         names += sym_size(sym->len);
+      }
+
+      lay.img = img;
+      lay.base = hdr.base;
+      lay.nodes = (Node_t *) (img + hdr.nodes);
+      lay.pk = img + hdr.packed;
+      lay.st = img + hdr.strings;
+      lay.next = 1;
+      place(lay, lay.nodes[0], root);
+
+      /* the magic goes in last, a partly written image never opens */
+      memcpy(hdr.magic, snap_magic, sizeof hdr.magic);
+      memcpy(img, &hdr, sizeof hdr);
+
+      munmap(img, hdr.size);
+      if(0 != rename(tmp_path.data(), file_path))
+      {
+         unlink(tmp_path.data());
+         trw_err("Unable to write snapshot");
+      }
+   }
+
+   void Helper_t::move_node(Node_t *pn, intptr_t delta)
+   {
+      move_ptr(pn->pnext, delta);
+      move_ptr(pn->pprev, delta);
+      move_ptr(pn->pparent, delta);
+      move_ptr(pn->name.psym, delta);
+
+      switch(pn->vtype)
+      {
+         case Valtype::String : move_ptr(pn->vstr, delta);
+                                break;
+
+         case Valtype::Packed : move_ptr(pn->vints, delta);
+                                break;
+
+         case Valtype::Array  :
+         case Valtype::Object : move_ptr(pn->vobj, delta);
+                                move_ptr(pn->vlast, delta);
+                                break;
+
+         default              : break;
+      }
+   }
+
+   /* the regions of an image are in order and fit in size bytes */
+   static bool check_header(const Image_t &hdr, uint64_t size)
+   {
+      return 0 == memcmp(hdr.magic, snap_magic, sizeof hdr.magic) and
+         SnapVersion == hdr.version and sizeof(Node_t) == hdr.node_size and
+         size == hdr.size and sizeof hdr <= hdr.nodes and
+         0 == hdr.nodes % alignof(Node_t) and hdr.nodes <= size and
+         hdr.count > 0 and hdr.count <= (size - hdr.nodes) / sizeof(Node_t) and
+         hdr.nodes + hdr.count * sizeof(Node_t) <= hdr.index and
+         hdr.index <= size and 0 == hdr.index % sizeof(uint64_t) and
+         hdr.slots > 0 and 0 == (hdr.slots & (hdr.slots - 1)) and
+         hdr.slots <= (size - hdr.index) / sizeof(uint64_t) and
+         hdr.index + hdr.slots * sizeof(uint64_t) <= hdr.names and
+         hdr.names <= hdr.packed and hdr.packed <= hdr.strings and
+         hdr.strings <= size and 0 == hdr.packed % sizeof(uint64_t);
+   }
+
+   /* whether len bytes at ptr, a pointer valid at base, lie within
+    * [from, to) of the image; a pointer below base wraps to a large
+    * offset and fails as well */
+   static bool in_span(const Image_t &hdr, const void *ptr, uint64_t len,
+         uint64_t from, uint64_t to)
+   {
+      uint64_t off = (uint64_t) ptr - hdr.base;
+      return from <= off and off <= to and len <= to - off;
+   }
+
+   /* index of the node ptr points to, or count when it is not one */
+   static uint64_t node_at(const Image_t &hdr, const Node_t *ptr)
+   {
+      uint64_t off = (uint64_t) ptr - hdr.base - hdr.nodes;
+      if(off % sizeof(Node_t) or off / sizeof(Node_t) >= hdr.count)
+         return hdr.count;
+      return off / sizeof(Node_t);
+   }
+
+   /* a name at off, NUL terminated within the names */
+   static bool check_sym(const char *img, const Image_t &hdr, uint64_t off)
+   {
+      if(off < hdr.names or off > hdr.packed or off % 8 or
+            hdr.packed - off < offsetof(Sym_t, str))
+         return false;
+      const Sym_t *sym = (const Sym_t *) (img + off);
+      return 0 <= sym->len and
+         (uint64_t) sym->len < hdr.packed - off - offsetof(Sym_t, str) and
+         0 == sym->str[sym->len];
+   }
+
+   /* every pointer and length of the image is checked against its
+    * region before anything follows it, and the nodes have to form the
+    * tree place() lays out: children adjacent and after their parent,
+    * each pointing back at it, so no walk can loop or leave the image;
+    * images are renamed in whole over the file, never written in place,
+    * so what is checked here is what the readers see */
+   bool Helper_t::check_image(const char *img, const Image_t &hdr)
+   {
+      const uint64_t *index = (const uint64_t *) (img + hdr.index);
+      uint64_t empty = 0;
+      for(uint64_t I = 0; I < hdr.slots; I++)
+      {
+         if(0 == index[I]) empty++;
+         else if(not check_sym(img, hdr, index[I])) return false;
+      }
+      if(0 == empty)    /* find_name stops at an empty slot */
+         return false;
+
+      /* no deeper than a parse can nest, readers walk it recursively */
+      vector<int> depth(hdr.count, 0);
+
+      const Node_t *nodes = (const Node_t *) (img + hdr.nodes);
+      for(uint64_t I = 0; I < hdr.count; I++)
+      {
+         const Node_t *pn = nodes + I;
+         const Node_t *self = (const Node_t *) (hdr.base + hdr.nodes) + I;
+
+         /* found from the address instead, see owner() */
+         if(pn->pdoc or pn->proot) return false;
+
+         if(pn->pnext and I + 1 != node_at(hdr, pn->pnext)) return false;
+         if(pn->pprev and I - 1 != node_at(hdr, pn->pprev)) return false;
+
+         if(0 == I)
+         {
+            if(pn->pparent or pn->pnext or pn->pprev) return false;
+         }
+         else
+         {
+            /* the parent, checked already, has it among its children */
+            uint64_t up = node_at(hdr, pn->pparent);
+            if(up >= I) return false;
+            const Node_t *par = nodes + up;
+            if(Valtype::Array != par->vtype and Valtype::Object != par->vtype)
+               return false;
+            if(node_at(hdr, par->vobj) > I or node_at(hdr, par->vlast) < I)
+               return false;
+            depth[I] = depth[up] + 1;
+            if(depth[I] > Lexer_t::MaxDepth) return false;
+         }
+
+         const Sym_t *psym = pn->name.psym;
+         if(psym and not check_sym(img, hdr, (uint64_t) psym - hdr.base))
+            return false;
+
+         if(pn->pcount < 0)
+            return false;
+
+         /* read as stored, an enum holding a stray value is no enum */
+         int vtype, vpacked;
+         memcpy(&vtype, &pn->vtype, sizeof vtype);
+         memcpy(&vpacked, &pn->vpacked, sizeof vpacked);
+
+         switch(vtype)
+         {
+            case Valtype::Int    :
+            case Valtype::Float  :
+            case Valtype::Bool   :
+            case Valtype::Null   : break;
+
+            case Valtype::String : if(pn->vlen < 0 or not in_span(hdr, pn->vstr,
+                                         (uint64_t) pn->vlen + 1, hdr.strings, hdr.size))
+                                      return false;
+                                   if(img[(uint64_t) pn->vstr - hdr.base + pn->vlen])
+                                      return false;
+                                   break;
+
+            case Valtype::Packed : if(Valtype::Int != vpacked and Valtype::Float != vpacked)
+                                      return false;
+                                   if(((uint64_t) pn->vints - hdr.base) % 8 or
+                                         not in_span(hdr, pn->vints, (uint64_t) pn->pcount * 8,
+                                            hdr.packed, hdr.strings))
+                                      return false;
+                                   break;
+
+            case Valtype::Array  :
+            case Valtype::Object : if(NULL == pn->vobj)
+                                   {
+                                      if(pn->vlast or pn->pcount) return false;
+                                   }
+                                   else
+                                   {
+                                      uint64_t first = node_at(hdr, pn->vobj);
+                                      uint64_t last = node_at(hdr, pn->vlast);
+                                      if(first <= I or last >= hdr.count or last < first or
+                                            last - first + 1 != (uint64_t) pn->pcount)
+                                         return false;
+                                      if(nodes[first].pprev or nodes[last].pnext)
+                                         return false;
+                                      for(uint64_t K = first; K <= last; K++)
+                                         if(self != nodes[K].pparent or
+                                               (K < last) != (NULL != nodes[K].pnext))
+                                            return false;
+                                   }
+                                   break;
+
+            default              : return false;
+         }
+      }
+
+      return true;
+   }
+
+   Snapshot_t * Helper_t::map_image(const char *file_path, Doc_t *pdoc)
+   {
+      int fd = open(file_path, O_RDONLY);
+      if(fd < 0)
+         trw_err("Unable to open snapshot");
+
+      Image_t hdr;
+      struct stat st;
+      bool valid = 0 == fstat(fd, &st) and
+         sizeof hdr == pread(fd, &hdr, sizeof hdr, 0) and
+         check_header(hdr, st.st_size);
+      if(not valid)
+      {
+         close(fd);
+         trw_err("Invalid snapshot");
+      }
+
+      /* shared with every other process mapping the file, needs no
+       * fix-ups as long as the preferred range is free */
+      void *want = (void *) hdr.base;
+      char *img = (char *) mmap(want, hdr.size, PROT_READ,
+            MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+      if(MAP_FAILED != img and want != img)
+      {
+         munmap(img, hdr.size);  /* kernel took the address as a hint */
+         img = (char *) MAP_FAILED;
+      }
+
+      /* otherwise a private copy with every pointer moved, which
+       * costs a pass over the nodes and their pages are not shared */
+      bool moved = false;
+      if(MAP_FAILED == img)
+      {
+         img = (char *) mmap(NULL, hdr.size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE, fd, 0);
+         moved = true;
+      }
+      close(fd);
+
+      if(MAP_FAILED == img)
+         trw_err("Unable to map snapshot");
+
+      /* checked as written, before any pointer is moved or followed */
+      if(not check_image(img, hdr))
+      {
+         munmap(img, hdr.size);
+         trw_err("Invalid snapshot");
+      }
+
+      if(moved)
+      {
+         Node_t *nodes = (Node_t *) (img + hdr.nodes);
+         for(uint64_t I = 0; I < hdr.count; I++)
+            move_node(nodes + I, img - (const char *) want);
+         mprotect(img, hdr.size, PROT_READ);
+      }
+
+      Snapshot_t *ps = new Snapshot_t;
+      ps->base = img;
+      ps->size = hdr.size;
+      ps->pdoc = pdoc;
+      ps->proot = (Node_t *) (img + hdr.nodes);
+      ps->index = (const uint64_t *) (img + hdr.index);
+      ps->mask = hdr.slots - 1;
+
+      for(int I = 0; I < MaxSnapshots; I++)
+      {
+         Snapshot_t *none = NULL;
+         if(snapshots[I].compare_exchange_strong(none, ps))
+            return ps;
+      }
+
+      munmap(img, hdr.size);
+      delete ps;
+      trw_err("Too many snapshots open");
+   }
+
+   void Helper_t::unmap_image(Snapshot_t *ps)
+   {
+      for(int I = 0; I < MaxSnapshots; I++)
+      {
+         Snapshot_t *cur = ps;
+         if(snapshots[I].compare_exchange_strong(cur, NULL))
+            break;
+      }
+      munmap((void *) ps->base, ps->size);
+      delete ps;
+   }
+
+   bool Doc_t::save_snapshot(const char *file_path)
+   {
+      try
+      {
+         if(NULL == proot)
+            trw_err("Nothing to save");
+         Helper_t::hash_node(proot);   /* the image keeps the hashes */
+         Helper_t::save_image(file_path, proot);
+         return OK;
+      }
+      catch(Exception exc)
+      {
+         error.desc = exc.msg;
+         error.line = error.colum = error.offset = 0;
+      }
+
+      return ERR;
+   }
+
+   Node_t & Doc_t::open_snapshot(const char *file_path)
+   {
+      try
+      {
+         /* released first, an image opened again gets the same range */
+         reset();
+         Snapshot_t *ps = Helper_t::map_image(file_path, this);
+         psnap = ps;
+         proot = ps->proot;
+         return *proot;
+      }
+      catch(Exception exc)
+      {
+         error.desc = exc.msg;
+         error.line = error.colum = error.offset = 0;
+      }
+
+      return oInvalid;
+   }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |       Node related implementations starts      |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+namespace Icejson
+{
+   Node_t::Node_t()    
+   {
+      pcount = 0;
+      vhash = 0;
+
+      pdoc = NULL;
+      vobj = NULL;
+
+      proot = NULL;
+      pnext = NULL;
+      pprev = NULL;
+      pparent = NULL;
+
+      vtype = Valtype::Invalid;
+   }
+
+   Iterator_t Node_t::front() const
+   {
+      if(this != &oInvalid and
+        (Valtype::Array == vtype or
+            Valtype::Object == vtype))
+         return Iterator_t(vobj);
+      if(this != &oInvalid and Valtype::Packed == vtype)
+         return Iterator_t(Helper_t::element(this, 0));
+      return Iterator_t(NULL);
+   }
+
+   Iterator_t Node_t::back() const
+   {
+      if(this != &oInvalid and
+        (Valtype::Array == vtype or
+            Valtype::Object == vtype))
+         return Iterator_t(vlast);
+      if(this != &oInvalid and Valtype::Packed == vtype)
+         return Iterator_t(Helper_t::element(this, pcount - 1));
+      return Iterator_t(NULL);
+   }
+
+   Doc_t & Node_t::doc() const     { return *Helper_t::owner(this); }
+
+   Node_t & Node_t::root() const   { return *proot;   }
+   Node_t & Node_t::prev() const   { return *pprev;   }
+   Node_t & Node_t::next() const   { return *pnext;   }
+   Node_t & Node_t::parent() const { return *pparent; }
+
+   int Node_t::count() const       { return pcount;   }
+
+   bool Node_t::valid() const     { return this != &oInvalid; }
+   Node_t::operator bool () const { return this != &oInvalid; }
+
+   Valtype_t Node_t::value_type() const { return vtype; }
+
+   Node_t::operator int    () const { return vint;  }
+   Node_t::operator long long () const { return vint; }
+   Node_t::operator char   () const { return vchar; }
+   Node_t::operator float  () const { return vreal; }
+   Node_t::operator double () const { return vreal; }
+
+   Valtype_t Node_t::packed_type() const
+   {
+      return Valtype::Packed == vtype ? vpacked : Valtype::Invalid;
+   }
+
+   const double * Node_t::packed_floats() const
+   {
+      return Valtype::Float == packed_type() ? vfloats : NULL;
+   }
+
+   const long long * Node_t::packed_ints() const
+   {
+      return Valtype::Int == packed_type() ? vints : NULL;
+   }
+
+   template <typename tn>
+   static int extract_numbers(const Node_t &node, tn *buf, int cap)
+   {
+      int len = 0;
+      const long long *ints = node.packed_ints();
+      const double *floats = node.packed_floats();
+
+      if(ints or floats)
+      {
+         for( ; len < cap and len < node.count(); len++)
+            buf[len] = ints ? (tn) ints[len] : (tn) floats[len];
+         return node.count();
+      }
+
+      if(Valtype::Array != node.value_type())
+         return -1;
+
+      /* elements past cap are still checked to be numbers */
+      for(Iterator_t itr = node.front(); itr; ++itr, len++)
+      {
+         Node_t &elm = *itr;
+         if(Valtype::Int != elm.value_type() and 
+               Valtype::Float != elm.value_type())
+            return -1;
+         else if(len >= cap)
+            continue;
+         else if(Valtype::Int == elm.value_type())
+            buf[len] = (tn) (long long) elm;
+         else
+            buf[len] = (tn) (double) elm;
+      }
+
+      return len;
+   }
+
+   int Node_t::extract(double *buf, int cap) const
+   {
+      return extract_numbers(*this, buf, cap);
+   }
+
+   int Node_t::extract(long long *buf, int cap) const
+   {
+      return extract_numbers(*this, buf, cap);
+   }
+
+   int Node_t::extract(vector<double> &vec) const
+   {
+      vec.resize(count());
+      int len = extract_numbers(*this, vec.data(), vec.size());
+      vec.resize(len < 0 ? 0 : len);
+      return len;
+   }
+
+   int Node_t::extract(vector<long long> &vec) const
+   {
+      vec.resize(count());
+      int len = extract_numbers(*this, vec.data(), vec.size());
+      vec.resize(len < 0 ? 0 : len);
+      return len;
+   }
+   Node_t::operator string () const 
+   { 
+      return Valtype::String == vtype ? string(vstr, vlen) : string();
+   }
+
+   Node_t & Node_t::operator [] (const int idx) const
+   {
+      if(Valtype::Array == vtype or 
+            Valtype::Object == vtype)
+      {
+         Node_t *cur = vobj;
+         for(int I = 0; cur && I < idx; I++)
+            cur = cur->pnext;
+         return *cur;
+      }
+      if(Valtype::Packed == vtype and 0 <= idx and idx < pcount)
+         return *Helper_t::element(this, idx);
+      return oInvalid;
+   }
+
+   Node_t & Node_t::operator [] (const char *name) const
+   {
+      if(Valtype::Object == vtype)
+      {
+         /* a name missing in the table is in no object */
+         const Sym_t *sym = Helper_t::find_name(Helper_t::owner(this),
+               name, strlen(name));
+         return sym ? (*this)[sym] : oInvalid;
+      }
+      return oInvalid;
+   }
+
+   Node_t & Node_t::operator [] (const Sym_t *sym) const
+   {
+      if(Valtype::Object == vtype)
+      {
+         Node_t *cur = vobj;
+         for( ; cur; cur = cur->pnext)
+            if(cur->name.sym() == sym)
+               return *cur;
+      }
+      return oInvalid;
+   }
+}
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |        Iterator related implementations starts      |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+namespace Icejson
+{
+   Iterator_t::Iterator_t() {}
+
+   Iterator_t::Iterator_t(Node_t *node) :
+      pcur(node) {}
+
+   Iterator_t::operator bool()
+   {
+      return pcur;
+   }
+
+   Node_t & Iterator_t::operator * ()
+   {
+      return *pcur;
+   }
+   
+   Iterator_t & Iterator_t::operator ++ ()
+   {
+      pcur = pcur->pnext;
+      return *this;
+   }
+
+   Iterator_t & Iterator_t::operator -- ()
+   {
+      pcur = pcur->pprev;
+      return *this;
+   }
+
+   Iterator_t Iterator_t::operator ++ (int)
+   {
+      Iterator_t itr(pcur);
+      pcur = pcur->pnext;
+      return itr;
+   }
+
+   Iterator_t Iterator_t::operator -- (int)
+   {
+      Iterator_t itr(pcur);
+      pcur = pcur->pprev;
+      return itr;
+   }
+
+   bool Iterator_t::operator == (const Iterator_t &rhs)
+   {
+      return pcur == rhs.pcur;
+   }
+
+   bool Iterator_t::operator != (const Iterator_t &rhs)
+   {
+      return pcur != rhs.pcur;
+   }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |       Reader related implementations starts           |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+namespace Icejson
+{
+   Reader_t::Reader_t(Lexer_t &lex) : lex(lex), first(false) {}
+
+   bool Reader_t::run(const char *json_str,
+         void (*fn)(Reader_t &rd, void *arg), void *arg, Error_t &err)
+   {
+      Lexer_t lex;
+
+      try
+      {
+         Reader_t rd(lex);
+         lex.load_string(json_str);
+         fn(rd, arg);
+
+         if('\0' != *lex.cur_pos)
+            trw_err("Unexpected data after root value");
+
+         return OK;
+      }
+      catch(Exception exc)
+      {
+         err.desc = exc.msg;
+         err.line = lex.line;
+         err.colum = lex.cur_pos - lex.line_bgn + 1;
+         err.offset = lex.cur_pos - lex.json_str + 1;
+      }
+
+      return ERR;
+   }
+
+   /* containers count against the depth limit of the parser, so a
+    * schema reading itself can not run the stack out */
+   bool Reader_t::begin_object()
+   {
+      if(LEX_OBJECT_OPEN != lex.cur_sym)
+         trw_err("Expected object");
+      if(++lex.depth > Lexer_t::MaxDepth)
+         trw_err("Nesting too deep");
+      lex.next();
+      return first = true;
+   }
+
+   bool Reader_t::next_key(const char * &key, int &len)
+   {
+      if(LEX_OBJECT_CLOSE == lex.cur_sym)
+      {
+         lex.depth--;
+         lex.next();
+         return first = false;
+      }
+
+      if(not first)
+      {
+         if(LEX_VALUE_SEPERATOR != lex.cur_sym)
+            trw_err("Expected value seperator");
+         lex.next();
+      }
+      first = false;
+
+      if(LEX_STRING != lex.cur_sym)
+         trw_err("Expected node name");
+
+      if(LEX_STRING != lex.get_key(key, len, kbuf))
+         trw_err("Invalid node name");
+
+      if(LEX_NAME_SEPERATOR != lex.next())
+         trw_err("Expected name seperator");
+      lex.next();
+
+      return OK;
+   }
+
+   bool Reader_t::begin_array()
+   {
+      if(LEX_ARRAY_OPEN != lex.cur_sym)
+         trw_err("Expected array");
+      if(++lex.depth > Lexer_t::MaxDepth)
+         trw_err("Nesting too deep");
+      lex.next();
+      return first = true;
+   }
+
+   bool Reader_t::next_item()
+   {
+      if(LEX_ARRAY_CLOSE == lex.cur_sym)
+      {
+         lex.depth--;
+         lex.next();
+         return first = false;
+      }
+
+      if(not first)
+      {
+         if(LEX_VALUE_SEPERATOR != lex.cur_sym)
+            trw_err("Expected value seperator");
+         lex.next();
+      }
+      first = false;
+
+      return OK;
+   }
+
+   bool Reader_t::null()
+   {
+      if(LEX_NULL != lex.cur_sym)
+         return false;
+      lex.next();
+      return true;
+   }
+
+   void Reader_t::skip() { lex.skip_value(); }
+
+   void Reader_t::read(long long &val)
+   {
+      double dval = 0;
+      if(LEX_INT != lex.cur_sym and LEX_NEG != lex.cur_sym)
+         trw_err("Expected number");
+      if(LEX_INT != lex.get_number(val, dval))
+         trw_err("Expected integer");
+   }
+
+   void Reader_t::read(int &val)
+   {
+      long long num = 0;
+      read(num);
+      if(num < INT_MIN or INT_MAX < num)
+         trw_err("Integer out of range");
+      val = num;
+   }
+
+   void Reader_t::read(double &val)
+   {
+      long long ival = 0;
+      if(LEX_INT != lex.cur_sym and LEX_NEG != lex.cur_sym)
+         trw_err("Expected number");
+      if(LEX_INT == lex.get_number(ival, val))
+         val = ival;
+   }
+
+   void Reader_t::read(vector<double> &vec)
+   {
+      vec.clear();
+      begin_array();
+      while(next_item())
+      {
+         vec.push_back(0);
+         read(vec.back());
+      }
+   }
+
+   void Reader_t::read(vector<long long> &vec)
+   {
+      vec.clear();
+      begin_array();
+      while(next_item())
+      {
+         vec.push_back(0);
+         read(vec.back());
+      }
+   }
+
+   size_t Reader_t::read(double *buf, size_t cap)
+   {
+      size_t len = 0;
+      begin_array();
+      for( ; next_item(); len++)
+      {
+         if(len >= cap)
+            trw_err("Array larger than buffer");
+         read(buf[len]);
+      }
+      return len;
+   }
+
+   size_t Reader_t::read(long long *buf, size_t cap)
+   {
+      size_t len = 0;
+      begin_array();
+      for( ; next_item(); len++)
+      {
+         if(len >= cap)
+            trw_err("Array larger than buffer");
+         read(buf[len]);
+      }
+      return len;
+   }
+
+   template <typename tn>
+   struct Span_t
+   {
+      tn *buf;
+      size_t count;
+
+      static void read(Reader_t &rd, void *arg)
+      {
+         Span_t *span = (Span_t *) arg;
+         span->count = rd.read(span->buf, span->count);
+      }
+   };
+
+   bool parse_array(const char *json_str, vector<double> &vec, Error_t &err)
+   {
+      return parse_struct(json_str, vec, err);
+   }
+
+   bool parse_array(const char *json_str, vector<long long> &vec, Error_t &err)
+   {
+      return parse_struct(json_str, vec, err);
+   }
+
+   bool parse_array(const char *json_str, double *buf, size_t &count, Error_t &err)
+   {
+      Span_t<double> span = { buf, count };
+      bool ret = Reader_t::run(json_str, &Span_t<double>::read, &span, err);
+      count = ret ? span.count : 0;
+      return ret;
+   }
+
+   bool parse_array(const char *json_str, long long *buf, size_t &count, Error_t &err)
+   {
+      Span_t<long long> span = { buf, count };
+      bool ret = Reader_t::run(json_str, &Span_t<long long>::read, &span, err);
+      count = ret ? span.count : 0;
+      return ret;
+   }
+
+   void Reader_t::read(float &val)
+   {
+      double num = 0;
+      read(num);
+      if(fabs(num) > FLT_MAX and not isinf(num))
+         trw_err("Number out of range");
+      val = num;
+   }
+
+   void Reader_t::read(bool &val)
+   {
+      if(LEX_BOOL_TRUE != lex.cur_sym and LEX_BOOL_FALSE != lex.cur_sym)
+         trw_err("Expected boolean");
+      val = LEX_BOOL_TRUE == lex.cur_sym;
+      lex.next();
+   }
+
+   void Reader_t::read(string &val)
+   {
+      if(LEX_STRING != lex.cur_sym)
+         trw_err("Expected string");
+      if(LEX_STRING != lex.get_str(val))
+         trw_err("Unterminated string value");
+      lex.next();
+   }
+
+   void append_value(string &out, long long val)
+   {
+      char buf[32];
+      out.append(buf, snprintf(buf, sizeof buf, "%lld", val));
+   }
+
+   void append_value(string &out, int val)
+   {
+      append_value(out, (long long) val);
+   }
+
+   /* JSON has no NaN or infinities, they go out as null which reads
+    * back leaving the member as it was */
+   void append_value(string &out, double val)
+   {
+      char buf[32];
+      if(not isfinite(val))
+         out += "null";
+      else
+         out.append(buf, snprintf(buf, sizeof buf, "%.17g", val));
+   }
+
+   void append_value(string &out, float val)
+   {
+      char buf[32];
+      if(not isfinite(val))
+         out += "null";
+      else
+         out.append(buf, snprintf(buf, sizeof buf, "%.9g", val));
+   }
+
+   void append_value(string &out, bool val)
+   {
+      out += val ? "true" : "false";
+   }
+
+   void append_value(string &out, const string &val)
+   {
+      append_escaped(out, val.data(), val.size());
+   }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |      Validator related implementations starts         |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+namespace Icejson
+{
+   /* bounded scanner behind Doc_t::validate, it never reads past
+    * end and keeps no state besides the cursor and the depth */
+   struct Validator_t
+   {
+      enum { MaxDepth = 1024 };
+
+      const unsigned char *bgn;
+      const unsigned char *cur;
+      const unsigned char *end;
+
+      int peek() const { return cur < end ? *cur : -1; }
+
+      void space()
+      {
+         while(cur < end and IS_CLASS(*cur, CC_SPACE))
+            cur++;
+      }
+
+      void digits()
+      {
+         while(cur < end and '0' <= *cur and *cur <= '9')
+            cur++;
+      }
+
+      void literal(const char *word, int len);
+      void number();
+      void escape();
+      void utf8();
+      void str();
+      void value(int depth);
+   };
+
+   void Validator_t::literal(const char *word, int len)
+   {
+      if(end - cur < len or 0 != memcmp(cur, word, len))
+         trw_err("Expected number, char, string, array or object");
+      cur += len;
+   }
+
+   void Validator_t::number()
+   {
+      if('-' == peek())
+         cur++;
+
+      if('0' == peek())
+         cur++;
+      else if('1' <= peek() and peek() <= '9')
+         digits();
+      else
+         trw_err("Expected digit");
+
+      if('.' == peek())
+      {
+         cur++;
+         if(not ('0' <= peek() and peek() <= '9'))
+            trw_err("Expected digit");
+         digits();
+      }
+
+      if('e' == peek() or 'E' == peek())
+      {
+         cur++;
+         if('+' == peek() or '-' == peek())
+            cur++;
+         if(not ('0' <= peek() and peek() <= '9'))
+            trw_err("Expected digit");
+         digits();
+      }
+   }
+
+   void Validator_t::escape()
+   {
+      if(++cur >= end)
+         trw_err("Invalid escape sequence");
+
+      switch(*cur)
+      {
+         case '"'  : case '\\' : case '/' :
+         case 'b'  : case 'f'  : case 'n' :
+         case 'r'  : case 't'  : cur++;
+                                 break;
+
+         case 'u'  : if(end - cur < 5)
+                        trw_err("Invalid unicode value");
+                     for(int I = 1; I <= 4; I++)
+                        if(not IS_CLASS(cur[I], CC_HEX))
+                           trw_err("Invalid unicode value");
+                     cur += 5;
+                     break;
+
+         default   : trw_err("Invalid escape sequence");
+      }
+   }
+
+   /* one multi byte sequence; the allowed range of the second byte
+    * depends on the first and rules out overlong forms, surrogates
+    * and code points above U+10FFFF */
+   void Validator_t::utf8()
+   {
+      unsigned char lead = *cur;
+      unsigned char lo = 0x80, hi = 0xBF;
+      int len = 0;
+
+      if(0xC2 <= lead and lead <= 0xDF)      len = 2;
+      else if(0xE0 == lead)                  len = 3, lo = 0xA0;
+      else if(0xED == lead)                  len = 3, hi = 0x9F;
+      else if(0xE1 <= lead and lead <= 0xEF) len = 3;
+      else if(0xF0 == lead)                  len = 4, lo = 0x90;
+      else if(0xF4 == lead)                  len = 4, hi = 0x8F;
+      else if(0xF1 <= lead and lead <= 0xF3) len = 4;
+      else trw_err("Invalid UTF-8");
+
+      if(end - cur < len or cur[1] < lo or hi < cur[1])
+         trw_err("Invalid UTF-8");
+      for(int I = 2; I < len; I++)
+         if(0x80 != (cur[I] & 0xC0))
+            trw_err("Invalid UTF-8");
+
+      cur += len;
+   }
+
+   void Validator_t::str()
+   {
+      cur++;   /* skip string symbol */
+
+      for( ; ; )
+      {
+#ifdef __SSE2__
+         /* skips 16 bytes at a time up to the first quote, backslash,
+          * control or non ascii byte, the signed compare against a
+          * space catches the last two together */
+         const __m128i quote = _mm_set1_epi8('"');
+         const __m128i slash = _mm_set1_epi8('\\');
+         const __m128i blank = _mm_set1_epi8(' ');
+         while(end - cur >= 16)
+         {
+            __m128i blk = _mm_loadu_si128((const __m128i *) cur);
+            __m128i hit = _mm_or_si128(_mm_cmplt_epi8(blk, blank),
+                  _mm_or_si128(_mm_cmpeq_epi8(blk, quote), _mm_cmpeq_epi8(blk, slash)));
+            int mask = _mm_movemask_epi8(hit);
+            if(mask)
+            {
+               cur += __builtin_ctz(mask);
+               break;
+            }
+            cur += 16;
+         }
+#endif
+
+         if(cur >= end)
+            trw_err("Unterminated string value");
+
+         unsigned char ch = *cur;
+         if('"' == ch)
+            break;
+         else if('\\' == ch)
+            escape();
+         else if(ch < 0x20)
+            trw_err("Control character in string");
+         else if(ch < 0x80)
+            cur++;
+         else
+            utf8();
+      }
+
+      cur++;   /* skip closing quote */
+   }
+
+   void Validator_t::value(int depth)
+   {
+      bool array = false;
+
+      switch(peek())
+      {
+         case '"' : str();
+                    return;
+
+         case '-' : case '0' : case '1' : case '2' : case '3' : case '4' :
+         case '5' : case '6' : case '7' : case '8' : case '9' :
+                    number();
+                    return;
+
+         case 't' : literal("true", 4);  return;
+         case 'f' : literal("false", 5); return;
+         case 'n' : literal("null", 4);  return;
+
+         case '[' : array = true;
+                    break;
+
+         case '{' : break;
+
+         default  : trw_err("Expected number, char, string, array or object");
+      }
+
+      if(++depth > MaxDepth)
+         trw_err("Nesting too deep");
+
+      int close = array ? ']' : '}';
+      cur++;
+      space();
+      if(close == peek())
+      {
+         cur++;
+         return;
+      }
+
+      for( ; ; )
+      {
+         if(not array)
+         {
+            if('"' != peek())
+               trw_err("Expected node name");
+            str();
+            space();
+            if(':' != peek())
+               trw_err("Expected name seperator");
+            cur++;
+            space();
+         }
+
+         value(depth);
+         space();
+
+         if(close == peek())
+            break;
+         if(',' != peek())
+            trw_err("Expected value seperator");
+         cur++;
+         space();
+      }
+
+      cur++;
+   }
+
+   bool validate(const char *json_str, size_t len, Error_t &err)
+   {
+      Validator_t vld;
+      vld.bgn = vld.cur = (const unsigned char *) json_str;
+      vld.end = vld.bgn + len;
+
+      try
+      {
+         vld.space();
+         if('{' != vld.peek())
+            trw_err("Expected object at start");
+
+         vld.value(0);
+         vld.space();
+
+         if(vld.cur != vld.end)
+            trw_err("Unexpected data after root value");
+
+         return OK;
+      }
+      catch(Exception exc)
+      {
+         /* lines are only counted when there is an error to report */
+         const unsigned char *line_bgn = vld.bgn;
+         err.line = 1;
+         for(const unsigned char *ptr = vld.bgn; ptr < vld.cur; ptr++)
+            if('\n' == *ptr)
+            {
+               err.line++;
+               line_bgn = ptr + 1;
+            }
+
+         err.desc = exc.msg;
+         err.colum = vld.cur - line_bgn + 1;
+         err.offset = vld.cur - vld.bgn + 1;
+      }
+
+      return ERR;
+   }
+
+   bool Doc_t::validate(const char *json_str, size_t len)
+   {
+      return Icejson::validate(json_str, len, error);
+   }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |       Hash related implementations starts      |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+namespace Icejson
+{
+   static inline uint64_t mix_hash(uint64_t val)
+   {
+      val ^= val >> 30;
+      val *= 0xBF58476D1CE4E5B9ULL;
+      val ^= val >> 27;
+      val *= 0x94D049BB133111EBULL;
+      return val ^ (val >> 31);
+   }
+
+   static inline uint64_t hash_value(int type, uint64_t val)
+   {
+      return mix_hash(val + type * 0x9E3779B97F4A7C15ULL);
+   }
+
+   /* string values and member names, mixed alike wherever hashed */
+   static inline uint64_t hash_string(const char *str, size_t len)
+   {
+      return hash_value(Valtype::String, hash_text(str, len));
+   }
+
+   static inline uint64_t hash_member(uint64_t val, const Name_t &name)
+   {
+      const Sym_t *sym = name.sym();
+      return mix_hash(val + (sym ? sym->hash : hash_text("", 0)));
+   }
+
+   /* a float holding a whole number that fits a long long */
+   static inline bool whole(double val, long long &ival)
+   {
+      if(not (val >= -9223372036854775808.0 and val < 9223372036854775808.0))
+         return false;
+      ival = (long long) val;
+      return ival == val;
+   }
+
+   /* numbers hash by value, a whole float as the integer it holds */
+   static uint64_t hash_number(double val)
+   {
+      long long ival;
+      if(whole(val, ival))
+         return hash_value(Valtype::Int, ival);
+
+      uint64_t bits;
+      if(isnan(val)) val = NAN;   /* one NaN whatever its payload */
+      memcpy(&bits, &val, 8);
+      return hash_value(Valtype::Float, bits);
+   }
+
+   uint64_t Helper_t::hash_node(const Node_t *pn)
+   {
+      uint64_t sum = 0;
+
+      switch(pn->vtype)
+      {
+         case Valtype::Int    : return hash_value(Valtype::Int, pn->vint);
+
+         case Valtype::Float  : return hash_number(pn->vreal);
+
+         case Valtype::String : return hash_string(pn->vstr, pn->vlen);
+
+         case Valtype::Bool   : return hash_value(Valtype::Bool, pn->vbool);
+
+         case Valtype::Packed : if(pn->vhash) return pn->vhash;
+                                sum = hash_value(Valtype::Array, 0);
+                                for(int I = 0; I < pn->pcount; I++)
+                                   if(Valtype::Float == pn->vpacked)
+                                      sum = mix_hash(sum + hash_number(pn->vfloats[I]));
+                                   else
+                                      sum = mix_hash(sum + hash_value(Valtype::Int, pn->vints[I]));
+                                break;
+
+         case Valtype::Array  : if(pn->vhash) return pn->vhash;
+                                sum = hash_value(Valtype::Array, 0);
+                                for(Node_t *itr = pn->vobj; itr; itr = itr->pnext)
+                                   sum = mix_hash(sum + hash_node(itr));
+                                break;
+
+         /* members are summed so their order does not count */
+         case Valtype::Object : if(pn->vhash) return pn->vhash;
+                                for(Node_t *itr = pn->vobj; itr; itr = itr->pnext)
+                                   sum += hash_member(hash_node(itr), itr->name);
+                                sum = hash_value(Valtype::Object, sum);
+                                break;
+
+         default              : return hash_value(Valtype::Null, 0);
+      }
+
+      sum += (0 == sum);   /* 0 is kept for not hashed */
+
+      if(pn->pdoc)         /* snapshot nodes are read-only */
+         pn->vhash = sum;
+
+      return sum;
+   }
+
+   /* drops the hashes cached from pn up; a container is never hashed
+    * before the ones below it, so the first one not hashed ends it */
+   void Helper_t::touch(Node_t *pn)
+   {
+      for( ; pn and pn->vhash; pn = pn->pparent)
+         pn->vhash = 0;
+   }
+
+   static void canonical_real(string &out, double val)
+   {
+      char buf[32];
+      long long ival;
+
+      if(whole(val, ival))
+         append_value(out, ival);
+      else if(isnan(val) or isinf(val))
+         out += isnan(val) ? "NaN" : val < 0 ? "-Infinity" : "Infinity";
+      else
+      {
+         /* fewest digits that read back as the same double */
+#ifdef __cpp_lib_to_chars
+         out.append(buf, to_chars(buf, buf + sizeof buf, val).ptr);
+#else
+         for(int prec = 15; prec <= 17; prec++)
+         {
+            snprintf(buf, sizeof buf, "%.*g", prec, val);
+            if(strtod(buf, NULL) == val)
+               break;
+         }
+         out += buf;
+#endif
+      }
+   }
+
+   static bool name_less(const Node_t *lhs, const Node_t *rhs)
+   {
+      int llen = lhs->name.size(), rlen = rhs->name.size();
+      int cmp = memcmp(lhs->name.data(), rhs->name.data(), min(llen, rlen));
+      return cmp ? cmp < 0 : llen < rlen;
+   }
+
+   void Helper_t::canonical(string &out, const Node_t *pn)
+   {
+      switch(pn->vtype)
+      {
+         case Valtype::Int    : append_value(out, pn->vint);
+                                break;
+
+         case Valtype::Float  : canonical_real(out, pn->vreal);
+                                break;
+
+         case Valtype::String : append_escaped(out, pn->vstr, pn->vlen);
+                                break;
+
+         case Valtype::Bool   : append_value(out, pn->vbool);
+                                break;
+
+         case Valtype::Packed : out += '[';
+                                for(int I = 0; I < pn->pcount; I++)
+                                {
+                                   if(I) out += ',';
+                                   if(Valtype::Float == pn->vpacked)
+                                      canonical_real(out, pn->vfloats[I]);
+                                   else
+                                      append_value(out, pn->vints[I]);
+                                }
+                                out += ']';
+                                break;
+
+         case Valtype::Array  : out += '[';
+                                for(Node_t *itr = pn->vobj; itr; itr = itr->pnext)
+                                {
+                                   canonical(out, itr);
+                                   if(itr->pnext) out += ',';
+                                }
+                                out += ']';
+                                break;
+
+         /* repeated names keep their order */
+         case Valtype::Object : { vector<const Node_t *> mems;
+                                  mems.reserve(pn->pcount);
+                                  for(Node_t *itr = pn->vobj; itr; itr = itr->pnext)
+                                     mems.push_back(itr);
+                                  stable_sort(mems.begin(), mems.end(), name_less);
+
+                                  out += '{';
+                                  for(size_t I = 0; I < mems.size(); I++)
+                                  {
+                                     if(I) out += ',';
+                                     append_escaped(out, mems[I]->name.data(),
+                                           mems[I]->name.size());
+                                     out += ':';
+                                     canonical(out, mems[I]);
+                                  }
+                                  out += '}';
+                                  break; }
+
+         default              : out += "null";
+      }
+   }
+
+   uint64_t Node_t::hash() const
+   {
+      return Helper_t::hash_node(this);
+   }
+
+   int Node_t::write_canonical(string &out) const
+   {
+      size_t len = out.size();
+      Helper_t::canonical(out, this);
+      return out.size() - len;
+   }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |       Patch related implementations starts     |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+namespace Icejson
+{
+   static inline bool is_array(Valtype_t type)
+   {
+      return Valtype::Array == type or Valtype::Packed == type;
+   }
+
+   /* keeps a float a float when read back and writes NaN and the
+    * infinities as ParseOptions::NanInfinity reads them */
+   static void append_real(string &out, double val)
+   {
+      if(isnan(val))
+         out += "NaN";
+      else if(isinf(val))
+         out += val < 0 ? "-Infinity" : "Infinity";
+      else
+      {
+         size_t len = out.size();
+         append_value(out, val);
+         if(string::npos == out.find_first_of(".e", len))
+            out += ".0";
+      }
+   }
+
+   /* reference token of a JSON pointer, ~ and / escaped */
+   static void push_token(string &path, const char *str, int len)
+   {
+      path += '/';
+      for(int I = 0; I < len; I++)
+         if('~' == str[I]) path += "~0";
+         else if('/' == str[I]) path += "~1";
+         else path += str[I];
+   }
+
+   static void push_index(string &path, int idx)
+   {
+      path += '/';
+      append_value(path, idx);
+   }
+
+   /* element of a plain or packed array as the diff sees it */
+   struct Elem_t
+   {
+      const Node_t *pn;    /* the element, or the packed array */
+      int pos;             /* position in the packed array, -1 if plain */
+      uint64_t hash;       /* as Node_t::hash gives it */
+   };
+
+   struct Diff_t
+   {
+      string *pout;
+      string path;         /* pointer to the nodes being compared */
+      int ops;
+   };
+
+   /* target of a JSON pointer, the root has no parent */
+   struct Pointer_t
+   {
+      Node_t *parent;
+      Node_t *target;      /* NULL when nothing is there yet */
+      string key;          /* last reference token, unescaped */
+      int index;           /* position when parent is an array */
+
+      /* element of an array the previous operation ended on, kept
+       * across operations so that a patch running along an array does
+       * not walk it from an end every time; NULL once it may be stale */
+      Node_t *cursor;
+      int cursor_index;
+   };
+
+   /* a number as its type and bits, pos is the position in a packed
+    * array and -1 for a plain node; false if it is not a number */
+   bool Helper_t::number(const Node_t *pn, int pos, int &type, uint64_t &bits)
+   {
+      if(pos >= 0)
+      {
+         type = pn->vpacked;
+         if(Valtype::Float == type)
+            memcpy(&bits, &pn->vfloats[pos], 8);
+         else
+            bits = pn->vints[pos];
+         return true;
+      }
+
+      type = pn->vtype;
+      if(Valtype::Int == type)
+         bits = pn->vint;
+      else if(Valtype::Float == type)
+         memcpy(&bits, &pn->vreal, 8);
+      else
+         return false;
+
+      return true;
+   }
+
+   void Helper_t::elems(const Node_t *pn, vector<Elem_t> &vec)
+   {
+      vec.reserve(pn->pcount);
+
+      if(Valtype::Packed == pn->vtype)
+      {
+         for(int I = 0; I < pn->pcount; I++)
+         {
+            uint64_t hash = Valtype::Float == pn->vpacked ?
+               hash_number(pn->vfloats[I]) : hash_value(Valtype::Int, pn->vints[I]);
+            Elem_t elm = { pn, I, hash };
+            vec.push_back(elm);
+         }
+         return;
+      }
+
+      for(Node_t *itr = pn->vobj; itr; itr = itr->pnext)
+      {
+         Elem_t elm = { itr, -1, hash_node(itr) };
+         vec.push_back(elm);
+      }
+   }
+
+   void Helper_t::append_json(string &out, const Node_t *pn, int pos)
+   {
+      if(pos >= 0)
+      {
+         if(Valtype::Float == pn->vpacked)
+            append_real(out, pn->vfloats[pos]);
+         else
+            append_value(out, pn->vints[pos]);
+         return;
+      }
+
+      switch(pn->vtype)
+      {
+         case Valtype::Int    : append_value(out, pn->vint);
+                                break;
+
+         case Valtype::Float  : append_real(out, pn->vreal);
+                                break;
+
+         case Valtype::String : append_escaped(out, pn->vstr, pn->vlen);
+                                break;
+
+         case Valtype::Bool   : append_value(out, pn->vbool);
+                                break;
+
+         case Valtype::Packed : out += '[';
+                                for(int I = 0; I < pn->pcount; I++)
+                                {
+                                   if(I) out += ',';
+                                   append_json(out, pn, I);
+                                }
+                                out += ']';
+                                break;
+
+         case Valtype::Array  : out += '[';
+                                for(Node_t *itr = pn->vobj; itr; itr = itr->pnext)
+                                {
+                                   append_json(out, itr);
+                                   if(itr->pnext) out += ',';
+                                }
+                                out += ']';
+                                break;
+
+         case Valtype::Object : out += '{';
+                                for(Node_t *itr = pn->vobj; itr; itr = itr->pnext)
+                                {
+                                   append_escaped(out, itr->name.data(), itr->name.size());
+                                   out += ':';
+                                   append_json(out, itr);
+                                   if(itr->pnext) out += ',';
+                                }
+                                out += '}';
+                                break;
+
+         default              : out += "null";
+      }
+   }
+
+   /* one operation at df.path, pos picks an element of a packed pn */
+   void Helper_t::emit(Diff_t &df, const char *op, const Node_t *pn, int pos)
+   {
+      string &out = *df.pout;
+
+      if(df.ops++) out += ',';
+      out += "{\"op\":\"";
+      out += op;
+      out += "\",\"path\":";
+      append_escaped(out, df.path.data(), df.path.size());
+      if(pn)
+      {
+         out += ",\"value\":";
+         append_json(out, pn, pos);
+      }
+      out += '}';
+   }
+
+   int Helper_t::diff(const Node_t *from, const Node_t *to, string &out)
+   {
+      Diff_t df;
+      df.pout = &out;
+      df.ops = 0;
+
+      out += '[';
+      diff_node(df, from, to);
+      out += ']';
+
+      return df.ops;
+   }
+
+   /* equal 64 bit hashes are taken as equal values without a walk, the
+    * cached ones of Node_t::hash, so an unchanged subtree costs O(1) */
+   void Helper_t::diff_node(Diff_t &df, const Node_t *a, const Node_t *b)
+   {
+      if(hash_node(a) == hash_node(b))
+         return;
+
+      if(Valtype::Object == a->vtype and Valtype::Object == b->vtype)
+         diff_object(df, a, b);
+      else if(is_array(a->vtype) and is_array(b->vtype))
+         diff_array(df, a, b);
+      else
+         emit(df, "replace", b);
+   }
+
+   static inline bool same_name(const Name_t &a, const Name_t &b)
+   {
+      return a.size() == b.size() and 0 == memcmp(a.data(), b.data(), a.size());
+   }
+
+   /* members are matched by name, the first of repeated names wins;
+    * while both sides list the same names in the same order they are
+    * paired in step and the map is only built for what is left */
+   void Helper_t::diff_object(Diff_t &df, const Node_t *a, const Node_t *b)
+   {
+      size_t len = df.path.size();
+      vector<Elem_t> mems;
+      vector<bool> matched;
+      unordered_map<string_view, int> names;
+
+      elems(b, mems);
+
+      size_t step = 0;
+      Node_t *itr = a->vobj;
+      for( ; itr and step < mems.size(); itr = itr->pnext, step++)
+      {
+         const Elem_t &mem = mems[step];
+         if(not same_name(itr->name, mem.pn->name))
+            break;
+
+         if(hash_node(itr) != mem.hash)
+         {
+            push_token(df.path, itr->name.data(), itr->name.size());
+            diff_node(df, itr, mem.pn);
+            df.path.resize(len);
+         }
+      }
+
+      matched.assign(mems.size(), false);
+      for(size_t I = mems.size(); I-- > step; )
+      {
+         const Name_t &name = mems[I].pn->name;
+         names[string_view(name.data(), name.size())] = I;
+      }
+
+      for( ; itr; itr = itr->pnext)
+      {
+         push_token(df.path, itr->name.data(), itr->name.size());
+
+         auto hit = names.find(string_view(itr->name.data(), itr->name.size()));
+         if(names.end() == hit)
+            emit(df, "remove");
+         else
+         {
+            const Elem_t &mem = mems[hit->second];
+            matched[hit->second] = true;
+            diff_node(df, itr, mem.pn);
+         }
+
+         df.path.resize(len);
+      }
+
+      for(size_t I = step; I < mems.size(); I++)
+         if(not matched[I])
+         {
+            const Name_t &name = mems[I].pn->name;
+            push_token(df.path, name.data(), name.size());
+            emit(df, "add", mems[I].pn);
+            df.path.resize(len);
+         }
+   }
+
+   /* the common head and tail are dropped, what is left is compared
+    * pair by pair and the longer side adds or removes the rest, so an
+    * insert or delete in one place costs one operation */
+   void Helper_t::diff_array(Diff_t &df, const Node_t *a, const Node_t *b)
+   {
+      size_t len = df.path.size();
+      vector<Elem_t> va, vb;
+
+      elems(a, va);
+      elems(b, vb);
+
+      int na = va.size(), nb = vb.size();
+      int head = 0, tail = 0;
+
+      while(head < na and head < nb and va[head].hash == vb[head].hash)
+         head++;
+      while(tail < na - head and tail < nb - head and
+            va[na - 1 - tail].hash == vb[nb - 1 - tail].hash)
+         tail++;
+
+      int ma = na - head - tail, mb = nb - head - tail;
+
+      for(int I = 0; I < ma and I < mb; I++)
+      {
+         const Elem_t &x = va[head + I], &y = vb[head + I];
+         if(x.hash == y.hash)
+            continue;
+
+         push_index(df.path, head + I);
+         if(x.pos < 0 and y.pos < 0)
+            diff_node(df, x.pn, y.pn);
+         else
+            emit(df, "replace", y.pn, y.pos);
+         df.path.resize(len);
+      }
+
+      for(int I = ma - 1; I >= mb; I--)
+      {
+         push_index(df.path, head + I);
+         emit(df, "remove");
+         df.path.resize(len);
+      }
+
+      for(int I = ma; I < mb; I++)
+      {
+         push_index(df.path, head + I);
+         emit(df, "add", vb[head + I].pn, vb[head + I].pos);
+         df.path.resize(len);
+      }
+   }
+
+   int Node_t::diff(const Node_t &to, string &patch) const
+   {
+      return Helper_t::diff(this, &to, patch);
+   }
+
+   const Node_t * Helper_t::member(const Node_t *obj, const char *name)
+   {
+      for(Node_t *itr = obj->vobj; itr; itr = itr->pnext)
+         if(itr->name == name)
+            return itr;
+      return NULL;
+   }
+
+   /* members in step while both list the same names in the same
+    * order, by name after that; the first of repeated names is taken
+    * and every name of b has to be in a as well */
+   bool Helper_t::same_members(const Node_t *a, const Node_t *b)
+   {
+      Node_t *x = a->vobj, *y = b->vobj;
+      for( ; x and x->name == y->name; x = x->pnext, y = y->pnext)
+         if(not same(x, y))
+            return false;
+
+      Node_t *rest = y;
+      for( ; x; x = x->pnext)
+      {
+         Node_t *z = b->vobj;
+         while(z and not (z->name == x->name))
+            z = z->pnext;
+         if(NULL == z or not same(x, z))
+            return false;
+      }
+
+      for(y = rest; y; y = y->pnext)
+      {
+         Node_t *z = a->vobj;
+         while(z and not (z->name == y->name))
+            z = z->pnext;
+         if(NULL == z)
+            return false;
+      }
+
+      return true;
+   }
+
+   /* numbers are equal by value whatever their type, so 1 and 1.0 are
+    * the same as RFC 6902 section 4.6 has it */
+   static bool same_number(int ta, uint64_t xa, int tb, uint64_t xb)
+   {
+      if(Valtype::Int == ta and Valtype::Int == tb)
+         return xa == xb;
+
+      if(Valtype::Int == ta)
+      {
+         swap(ta, tb);
+         swap(xa, xb);
+      }
+
+      double da, db;
+      long long ival;
+      memcpy(&da, &xa, 8);
+      memcpy(&db, &xb, 8);
+
+      if(Valtype::Float == tb)
+         return da == db;
+      return whole(da, ival) and ival == (long long) xb;
+   }
+
+   /* deep equality, numbers compare by value */
+   bool Helper_t::same(const Node_t *a, const Node_t *b)
+   {
+      if(Valtype::Packed == a->vtype or Valtype::Packed == b->vtype)
+      {
+         if(not is_array(a->vtype) or not is_array(b->vtype) or
+               a->pcount != b->pcount)
+            return false;
+
+         const Node_t *na = Valtype::Packed == a->vtype ? NULL : a->vobj;
+         const Node_t *nb = Valtype::Packed == b->vtype ? NULL : b->vobj;
+         for(int I = 0; I < a->pcount; I++)
+         {
+            int ta = 0, tb = 0;
+            uint64_t xa = 0, xb = 0;
+            if(not number(na ? na : a, na ? -1 : I, ta, xa) or
+                  not number(nb ? nb : b, nb ? -1 : I, tb, xb) or
+                  not same_number(ta, xa, tb, xb))
+               return false;
+            if(na) na = na->pnext;
+            if(nb) nb = nb->pnext;
+         }
+         return true;
+      }
+
+      int ta = 0, tb = 0;
+      uint64_t xa = 0, xb = 0;
+      if(number(a, -1, ta, xa) and number(b, -1, tb, xb))
+         return same_number(ta, xa, tb, xb);
+
+      if(a->vtype != b->vtype or a->pcount != b->pcount)
+         return false;
+
+      switch(a->vtype)
+      {
+         case Valtype::String : return a->vlen == b->vlen and
+                                   0 == memcmp(a->vstr, b->vstr, a->vlen);
+
+         case Valtype::Bool   : return a->vbool == b->vbool;
+
+         case Valtype::Array  : for(Node_t *x = a->vobj, *y = b->vobj; x;
+                                      x = x->pnext, y = y->pnext)
+                                   if(not same(x, y))
+                                      return false;
+                                return true;
+
+         case Valtype::Object : return same_members(a, b);
+
+         default              : return true;
+      }
+   }
+
+   /* deep copy owned by pdoc, names and strings included */
+   Node_t * Helper_t::clone(Doc_t *pdoc, const Node_t *src)
+   {
+      Parser_t *pn = new Parser_t(pdoc, src->vtype);
+
+      if(not src->name.empty())
+         pn->name.psym = pdoc->names().intern(src->name.data(), src->name.size());
+
+      switch(src->vtype)
+      {
+         case Valtype::Int    : pn->vint = src->vint;
+                                break;
+
+         case Valtype::Float  : pn->vreal = src->vreal;
+                                break;
+
+         case Valtype::Bool   : pn->vbool = src->vbool;
+                                break;
+
+         case Valtype::String : pn->vstr = pdoc->parena->copy(src->vstr, src->vlen);
+                                pn->vlen = src->vlen;
+                                break;
+
+         case Valtype::Packed : pn->pcount = src->pcount;
+                                pn->vpacked = src->vpacked;
+                                if(Valtype::Float == src->vpacked)
+                                {
+                                   pn->vfloats = new double [src->pcount];
+                                   memcpy(pn->vfloats, src->vfloats, src->pcount * 8);
+                                }
+                                else
+                                {
+                                   pn->vints = new long long [src->pcount];
+                                   memcpy(pn->vints, src->vints, src->pcount * 8);
+                                }
+                                break;
+
+         case Valtype::Array  :
+         case Valtype::Object : for(Node_t *itr = src->vobj; itr; itr = itr->pnext)
+                                   attach(pn, clone(pdoc, itr), NULL);
+                                break;
+
+         default              : break;
+      }
+
+      return pn;
+   }
+
+   /* turns a packed array into a plain one before it is changed */
+   void Helper_t::unpack(Doc_t *pdoc, Node_t *pn)
+   {
+      drop_view(pn);
+      int count = pn->pcount;
+      Valtype_t type = pn->vpacked;
+      double *floats = pn->vfloats;
+      long long *ints = pn->vints;
+
+      touch(pn);
+      pn->vtype = Valtype::Array;
+      pn->vobj = NULL;
+      pn->pcount = 0;
+
+      for(int I = 0; I < count; I++)
+      {
+         Parser_t *elm = new Parser_t(pdoc, type);
+         if(Valtype::Float == type)
+            elm->vreal = floats[I];
+         else
+            elm->vint = ints[I];
+         attach(pn, elm, NULL);
+      }
+
+      if(Valtype::Float == type)
+         delete [] floats;
+      else
+         delete [] ints;
+   }
+
+   Node_t * Helper_t::element(const Node_t *pn, int idx)
+   {
+      Doc_t *pdoc = owner(pn);
+      lock_guard<mutex> lck(pdoc->pviews->mtx);
+
+      Node_t * &elms = pdoc->pviews->nodes[pn];
+      if(NULL == elms)
+      {
+         elms = new Node_t [pn->pcount];
+         for(int I = 0; I < pn->pcount; I++)
+         {
+            Node_t &elm = elms[I];
+            elm.pdoc = pdoc;
+            elm.proot = pn->proot;
+            elm.pparent = (Node_t *) pn;
+            elm.pprev = I ? &elms[I - 1] : NULL;
+            elm.pnext = I + 1 < pn->pcount ? &elms[I + 1] : NULL;
+            elm.vtype = pn->vpacked;
+            if(Valtype::Float == pn->vpacked)
+               elm.vreal = pn->vfloats[I];
+            else
+               elm.vint = pn->vints[I];
+         }
+      }
+
+      return &elms[idx];
+   }
+
+   /* the array goes or changes, which is never while it is read */
+   void Helper_t::drop_view(Node_t *pn)
+   {
+      Views_t *pv = pn->pdoc ? pn->pdoc->pviews : NULL;
+      if(NULL == pv or pv->nodes.empty())
+         return;
+
+      auto itr = pv->nodes.find(pn);
+      if(itr == pv->nodes.end())
+         return;
+      delete [] itr->second;
+      pv->nodes.erase(itr);
+   }
+
+   /* links pn into parent before pos, at the end when pos is NULL */
+   void Helper_t::attach(Node_t *parent, Node_t *pn, Node_t *pos)
+   {
+      touch(parent);
+      pn->pparent = parent;
+      pn->pnext = pos;
+      pn->pprev = pos ? pos->pprev : (parent->vobj ? parent->vlast : NULL);
+
+      if(pn->pprev) pn->pprev->pnext = pn;
+      else parent->vobj = pn;
+
+      if(pos) pos->pprev = pn;
+      else parent->vlast = pn;
+
+      parent->pcount++;
+   }
+
+   void Helper_t::detach(Node_t *pn)
+   {
+      Node_t *parent = pn->pparent;
+      touch(parent);
+
+      if(pn->pprev) pn->pprev->pnext = pn->pnext;
+      else parent->vobj = pn->pnext;
+
+      if(pn->pnext) pn->pnext->pprev = pn->pprev;
+      else parent->vlast = pn->pprev;
+
+      parent->pcount--;
+      pn->pparent = pn->pprev = pn->pnext = NULL;
+   }
+
+   /* write is set when the operation changes what path points at,
+    * a packed array there is made plain; reads leave it packed and
+    * get the element from its views */
+   void Helper_t::resolve(Doc_t *pdoc, const char *path, Pointer_t &ptr, bool write)
+   {
+      ptr.parent = NULL;
+      ptr.target = pdoc->proot;
+      ptr.index = -1;
+
+      if('\0' != *path and '/' != *path)
+         trw_err("Invalid JSON pointer");
+
+      while('/' == *path)
+      {
+         Node_t *pn = ptr.target;
+         if(NULL == pn)
+            trw_err("Path not found");
+
+         ptr.parent = pn;
+         ptr.target = NULL;
+         ptr.key.clear();
+
+         for(path++; '/' != *path and '\0' != *path; path++)
+         {
+            if('~' != *path)
+               ptr.key += *path;
+            else if('0' == *++path)
+               ptr.key += '~';
+            else if('1' == *path)
+               ptr.key += '/';
+            else
+               trw_err("Invalid JSON pointer");
+         }
+
+         if(Valtype::Object == pn->vtype)
+         {
+            /* a name missing in the table is in no object */
+            const Sym_t *sym = find_name(pdoc, ptr.key.data(), ptr.key.size());
+            for(Node_t *itr = sym ? pn->vobj : NULL; itr; itr = itr->pnext)
+               if(itr->name.sym() == sym)
+               {
+                  ptr.target = itr;
+                  break;
+               }
+            continue;
+         }
+
+         if(not is_array(pn->vtype))
+            trw_err("Path not found");
+
+         bool packed = Valtype::Packed == pn->vtype;
+         if(packed and write and '\0' == *path)
+         {
+            unpack(pdoc, pn);
+            packed = false;
+         }
+
+         /* - is the end of the array, otherwise digits without a
+          * leading zero */
+         const char *key = ptr.key.data();
+         if("-" == ptr.key)
+            ptr.index = pn->pcount;
+         else if(ptr.key.empty() or ptr.key.size() > 9 or
+               ('0' == key[0] and ptr.key.size() > 1) or
+               ptr.key.size() != strspn(key, "0123456789"))
+            trw_err("Invalid array index");
+         else
+            ptr.index = atoi(key);
+
+         if(ptr.index > pn->pcount)
+            trw_err("Index out of range");
+
+         /* walks in from the nearer end or from the cursor */
+         int pos = 0;
+         int last = pn->pcount - 1;
+         if(ptr.index == pn->pcount)
+            ptr.target = NULL;
+         else if(packed)
+            ptr.target = element(pn, ptr.index);
+         else
+         {
+            ptr.target = pn->vobj;
+            if(last - ptr.index < ptr.index)
+               ptr.target = pn->vlast, pos = last;
+            if(ptr.cursor and pn == ptr.cursor->pparent and
+                  abs(ptr.cursor_index - ptr.index) < abs(pos - ptr.index))
+               ptr.target = ptr.cursor, pos = ptr.cursor_index;
+
+            for( ; pos < ptr.index; pos++)
+               ptr.target = ptr.target->pnext;
+            for( ; pos > ptr.index; pos--)
+               ptr.target = ptr.target->pprev;
+         }
+      }
+   }
+
+   /* puts pn where ptr points, replacing what is there when replace is
+    * set or the parent is an object and inserting into an array */
+   void Helper_t::put(Doc_t *pdoc, Pointer_t &ptr, Node_t *pn, bool replace)
+   {
+      Node_t *old = ptr.target;
+
+      if(NULL == ptr.parent)
+      {
+         pn->name.psym = NULL;
+         free_node(pdoc->proot);
+         pdoc->proot = pn;
+         return;
+      }
+
+      if(replace and NULL == old)
+         trw_err("Path not found");
+
+      if(Valtype::Object == ptr.parent->vtype)
+         pn->name.psym = pdoc->names().intern(ptr.key.data(), ptr.key.size());
+      else
+         pn->name.psym = NULL;
+
+      attach(ptr.parent, pn, old);
+
+      if(old and (replace or Valtype::Object == ptr.parent->vtype))
+      {
+         detach(old);
+         free_node(old);
+      }
+   }
+
+   void Helper_t::apply_op(Doc_t *pdoc, const Node_t *op, Pointer_t &ptr)
+   {
+      if(Valtype::Object != op->vtype)
+         trw_err("Expected operation object");
+
+      const Node_t *pop = member(op, "op");
+      const Node_t *ppath = member(op, "path");
+      const Node_t *pvalue = member(op, "value");
+      const Node_t *pfrom = member(op, "from");
+
+      if(NULL == pop or Valtype::String != pop->vtype)
+         trw_err("Expected op");
+      if(NULL == ppath or Valtype::String != ppath->vtype)
+         trw_err("Expected path");
+
+      const char *name = pop->vstr;
+      const char *path = ppath->vstr;
+      bool move = (0 == strcmp(name, "move"));
+      Node_t *pn = NULL;
+      Node_t *home = NULL, *next = NULL;   /* where a moved node was */
+
+      if(move or 0 == strcmp(name, "copy"))
+      {
+         if(NULL == pfrom or Valtype::String != pfrom->vtype)
+            trw_err("Expected from");
+
+         resolve(pdoc, pfrom->vstr, ptr, move);
+         if(NULL == ptr.target)
+            trw_err("Path not found");
+
+         if(not move)
+            pn = clone(pdoc, ptr.target);
+         else if(0 == strcmp(path, pfrom->vstr))
+            return;
+         else if(0 == strncmp(path, pfrom->vstr, pfrom->vlen) and
+               '/' == path[pfrom->vlen])
+            trw_err("Can not move a node into itself");
+         else
+         {
+            pn = ptr.target;
+            home = pn->pparent;
+            next = pn->pnext;
+            detach(pn);
+            ptr.cursor = NULL;   /* positions after pn have moved */
+         }
+      }
+      else if(0 == strcmp(name, "add") or 0 == strcmp(name, "replace") or
+            0 == strcmp(name, "test"))
+      {
+         if(NULL == pvalue)
+            trw_err("Expected value");
+      }
+      else if(0 != strcmp(name, "remove"))
+         trw_err("Unknown op");
+
+      try
+      {
+         resolve(pdoc, path, ptr, 0 != strcmp(name, "test"));
+
+         if(0 == strcmp(name, "test"))
+         {
+            if(NULL == ptr.target or not same(ptr.target, pvalue))
+               trw_err("Test failed");
+         }
+         else if(0 == strcmp(name, "remove"))
+         {
+            if(NULL == ptr.parent)
+               trw_err("Can not remove the root");
+            if(NULL == ptr.target)
+               trw_err("Path not found");
+            Node_t *next = ptr.target->pnext;
+            detach(ptr.target);
+            free_node(ptr.target);
+            ptr.target = next;   /* now at the removed position */
+         }
+         else
+         {
+            if(NULL == pn)
+               pn = clone(pdoc, pvalue);
+            put(pdoc, ptr, pn, 0 == strcmp(name, "replace"));
+            ptr.target = pn;
+         }
+      }
+      catch(Exception exc)
+      {
+         /* a moved node goes back where it was, a copy has nowhere to go */
+         if(home)
+            attach(home, pn, next);
+         else
+            free_node(pn);
+         throw;
+      }
+
+      /* only a node of a plain array at a known position is safe to
+       * keep, the views of a packed one go when it is unpacked */
+      if(ptr.parent and Valtype::Array == ptr.parent->vtype and ptr.target)
+      {
+         ptr.cursor = ptr.target;
+         ptr.cursor_index = ptr.index;
+      }
+      else
+         ptr.cursor = NULL;
+   }
+
+   void Helper_t::apply_patch(Doc_t *pdoc, const Node_t *patch, int &done)
+   {
+      if(Valtype::Array != patch->vtype)
+         trw_err("Expected array of operations");
+
+      Pointer_t ptr;
+      ptr.cursor = NULL;
+      ptr.cursor_index = 0;
+
+      for(Node_t *itr = patch->vobj; itr; itr = itr->pnext, done++)
+         apply_op(pdoc, itr, ptr);
+   }
+
+   bool Doc_t::apply_patch(Node_t &patch)
+   {
+      int done = 0;
+
+      try
+      {
+         if(psnap)
+            trw_err("Snapshot documents are read-only");
+
+         Helper_t::apply_patch(this, &patch, done);
+
+         return OK;
+      }
+      catch(Exception exc)
+      {
+         error.desc = exc.msg;
+         error.line = 0;
+         error.colum = 0;
+         error.offset = done + 1;
+      }
+
+      return ERR;
+   }
+
+   bool Doc_t::apply_patch(const char *patch_json)
    {
-      Helper_t::free_node(proot);
+      Doc_t patch;
+      patch.options = ParseOptions::AnyRoot | (options & ParseOptions::NanInfinity);
+      patch.parse_string(patch_json);
+
+      if(NULL == patch.proot)
+      {
+         error = patch.error;
+         return ERR;
+      }
+
+      return apply_patch(*patch.proot);
    }
 }
 
 
-/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
- |       Writer realted implementation            |
- `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |     Async loading related implementations starts      |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
 namespace Icejson
 {
-   Writer_t::Writer_t() 
+   /* library threads which read and parse the documents handed to
+    * parse_async, started on first use; shutdown_async and the exit
+    * of the process let them finish what is queued and join them */
+   struct Loader_t
    {
-      int_format = "%d";
-      str_format = "%s";
-      float_format = "%f";
+      enum { MaxWorkers = 4 };
+
+      struct Job_t
+      {
+         Doc_t *pdoc;
+         int fd;
+         void (*done)(Doc_t &doc, void *arg);
+         void *arg;
+      };
+
+      mutex mtx;
+      condition_variable cv;
+      deque<Job_t> jobs;
+      vector<thread> workers;
+      bool stopping = false;
+
+      ~Loader_t() { stop(); }
+
+      static Loader_t & instance();
+
+      void post(const Job_t &job);
+      void stop();
+      void worker();
+   };
+
+   Loader_t & Loader_t::instance()
+   {
+      static Loader_t loader;
+      return loader;
    }
 
-   int Node_t::write(FILE *fh, const char *pad)
+   void Loader_t::post(const Job_t &job)
    {
-      return Helper_t::write(fh, this, pad);
+      {
+         lock_guard<mutex> lck(mtx);
+         if(workers.empty())
+         {
+            int count = min<int>(MaxWorkers, max(1u, thread::hardware_concurrency()));
+            for(int I = 0; I < count; I++)
+               workers.emplace_back(&Loader_t::worker, this);
+         }
+         jobs.push_back(job);
+      }
+      cv.notify_one();
    }
-   
-   int Node_t::write(char *str, const char *pad)
+
+   /* the workers drain the queue before they see stopping, so every
+    * posted job still gets its done call */
+   void Loader_t::stop()
    {
-      return Helper_t::write(str, this, pad);
+      vector<thread> quit;
+      {
+         lock_guard<mutex> lck(mtx);
+         stopping = true;
+         quit.swap(workers);
+      }
+      cv.notify_all();
+
+      for(thread &thd : quit)
+         thd.join();
+
+      lock_guard<mutex> lck(mtx);
+      stopping = false;
    }
 
-   int Node_t::write(ostream &os, const char *pad)
+   void Loader_t::worker()
    {
-      ostream *pos = &os;
-      return Helper_t::write(pos, this, pad);
+      for( ; ; )
+      {
+         unique_lock<mutex> lck(mtx);
+         cv.wait(lck, [this] { return stopping or not jobs.empty(); });
+         if(jobs.empty())
+            return;
+         Job_t job = jobs.front();
+         jobs.pop_front();
+         lck.unlock();
+
+         Helper_t::load(job.pdoc, job.fd);
+         job.done(*job.pdoc, job.arg);
+      }
+   }
+
+   /* reads fd from its offset to the end; a regular file is read into
+    * a buffer of its size, anything else into one growing as it fills */
+   static char * read_all(int fd, size_t &len)
+   {
+      struct stat st;
+      size_t cap = 1 << 16;
+      if(0 == fstat(fd, &st) and S_ISREG(st.st_mode))
+         cap = st.st_size + 1;   /* one more to see the end at once */
+
+      char *buf = (char *) malloc(cap + 1);
+      len = 0;
+
+      while(buf)
+      {
+         if(len == cap)
+         {
+            cap *= 2;
+            char *big = (char *) realloc(buf, cap + 1);
+            if(NULL == big) break;
+            buf = big;
+         }
+
+         ssize_t got = read(fd, buf + len, cap - len);
+         if(got > 0)
+            len += got;
+         else if(0 == got)
+         {
+            buf[len] = '\0';
+            return buf;
+         }
+         else if(EINTR != errno)
+            break;
+      }
+
+      free(buf);
+      return NULL;
+   }
+
+   void Helper_t::load(Doc_t *pdoc, int fd)
+   {
+      size_t len = 0;
+      char *json_str = read_all(fd, len);
+
+      if(json_str)
+      {
+         pdoc->parse_string(json_str);
+         free(json_str);
+         return;
+      }
+
+      /* no stale tree is left for the caller to mistake */
+      pdoc->reset();
+      pdoc->error.desc = "Unable to read file";
+      pdoc->error.line = pdoc->error.colum = pdoc->error.offset = 0;
+   }
+
+   void Doc_t::parse_async(int fd, void (*done)(Doc_t &doc, void *arg), void *arg)
+   {
+      Loader_t::Job_t job = { this, fd, done, arg };
+      Loader_t::instance().post(job);
+   }
+
+   void shutdown_async()
+   {
+      Loader_t::instance().stop();
    }
 }
 
 
-/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
- |       Node related implementations starts      |
- `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |     Shared document related implementations starts    |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
 namespace Icejson
 {
-   Node_t::Node_t()    
+   /* marks a reader slot claimed but not yet published */
+   #define oBusySlot ((SharedDoc_t::Version_t *) 1)
+
+   struct SharedDoc_t::Version_t
    {
-      pcount = 0;
+      Version_t() : pnext(NULL) {}
 
-      pdoc = NULL;
-      vobj = NULL;
+      Doc_t doc;
+      Version_t *pnext; /* next in retired list */
+   };
 
-      proot = NULL;
-      pnext = NULL;
-      pprev = NULL;
-      pparent = NULL;
+   /* the nanoseconds of st_mtime, st_mtim as POSIX names it except
+    * on macOS */
+#ifdef __APPLE__
+   #define MTIME_NSEC(st) ((st).st_mtimespec.tv_nsec)
+#else
+   #define MTIME_NSEC(st) ((st).st_mtim.tv_nsec)
+#endif
 
-      vtype = Valtype::Invalid;
+   /* changes whenever the file is modified or replaced */
+   static long long file_stamp(const char *file_path)
+   {
+      struct stat st;
+      if(0 != stat(file_path, &st))
+         return -1;
+      return (long long) st.st_mtime * 1000000000LL +
+         MTIME_NSEC(st) + st.st_size * 31 + st.st_ino;
    }
 
-   Iterator_t Node_t::front() const
+   SharedDoc_t::Guard_t::Guard_t(atomic<Version_t *> *slot, Version_t *ver) :
+      pslot(slot), pver(ver) {}
+
+   SharedDoc_t::Guard_t::Guard_t(Guard_t &&rhs) :
+      pslot(rhs.pslot), pver(rhs.pver)
    {
-      if(this != &oInvalid and
-        (Valtype::Array == vtype or
-            Valtype::Object == vtype))
-         return Iterator_t(vobj);
-      return Iterator_t(NULL);
+      rhs.pslot = NULL;
+      rhs.pver = NULL;
    }
 
-   Iterator_t Node_t::back() const
+   SharedDoc_t::Guard_t::~Guard_t()
    {
-      if(this != &oInvalid and
-        (Valtype::Array == vtype or
-            Valtype::Object == vtype))
-         return Iterator_t(vlast);
-      return Iterator_t(NULL);
+      if(pslot) pslot->store(NULL);
    }
 
-   Doc_t & Node_t::doc() const     { return *pdoc;    }
+   Doc_t & SharedDoc_t::Guard_t::doc() const
+   {
+      assert(pver);   /* an empty guard has no document */
+      return pver->doc;
+   }
 
-   Node_t & Node_t::root() const   { return *proot;   }
-   Node_t & Node_t::prev() const   { return *pprev;   }
-   Node_t & Node_t::next() const   { return *pnext;   }
-   Node_t & Node_t::parent() const { return *pparent; }
+   Node_t & SharedDoc_t::Guard_t::root() const 
+   {
+      return pver ? pver->doc.root() : oInvalid; 
+   }
 
-   int Node_t::count() const       { return pcount;   }
+   SharedDoc_t::Guard_t::operator bool () const 
+   { 
+      return pver and pver->doc.root(); 
+   }
 
-   bool Node_t::valid() const     { return this != &oInvalid; }
-   Node_t::operator bool () const { return this != &oInvalid; }
+   SharedDoc_t::SharedDoc_t() : pcur(NULL)
+   {
+      options = ParseOptions::Strict;
+      stopping = false;
+      retired = NULL;
+      for(int I = 0; I < MaxReaders; I++)
+         slots[I].pver.store(NULL);
+   }
 
-   Valtype_t Node_t::value_type() const { return vtype; }
+   SharedDoc_t::Guard_t SharedDoc_t::pin() const
+   {
+      enum { Passes = 4 };
+      static thread_local int hint = 0;
+      atomic<Version_t *> *slot = NULL;
 
-   Node_t::operator int    () const { return vint;  }
-   Node_t::operator char   () const { return vchar; }
-   Node_t::operator float  () const { return vreal; }
-   Node_t::operator string () const { return vstr;  }
+      /* claim a free slot, yielding between passes over a full table;
+       * a thread can hold all of them itself, so it gives up in the end
+       * rather than waiting for a guard that never goes */
+      for(int N = 0; NULL == slot and N < Passes * MaxReaders; N++)
+      {
+         int I = (hint + N) % MaxReaders;
+         Version_t *expected = NULL;
+         if(slots[I].pver.compare_exchange_strong(expected, oBusySlot))
+         {
+            hint = I;
+            slot = &slots[I].pver;
+         }
+         else if(MaxReaders - 1 == N % MaxReaders)
+            this_thread::yield();
+      }
 
-   Node_t & Node_t::operator [] (const int idx) const
-   {
-      if(Valtype::Array == vtype or 
-            Valtype::Object == vtype)
+      if(NULL == slot)
+         return Guard_t(NULL, NULL);
+
+      /* publish the version and make sure it was not swapped out meanwhile */
+      Version_t *ver = NULL;
+      do
       {
-         Node_t *cur = vobj;
-         for(int I = 0; cur && I < idx; I++)
-            cur = cur->pnext;
-         return *cur;
+         ver = pcur.load();
+         slot->store(ver ? ver : oBusySlot);
+      } while(ver != pcur.load());
+
+      if(NULL == ver)
+      {
+         slot->store(NULL);
+         return Guard_t(NULL, NULL);
       }
-      return oInvalid;
+
+      return Guard_t(slot, ver);
    }
 
-   Node_t & Node_t::operator [] (const char *name) const
+   Error_t SharedDoc_t::error() const
+   {
+      lock_guard<mutex> lck(mtx);
+      return err;
+   }
+
+   bool SharedDoc_t::load(const char *file_path)
    {
-      if(Valtype::Object == vtype)
       {
-         Node_t *cur = vobj;
-         for( ; cur; cur = cur->pnext)
-            if(cur->name == name)
-               return *cur;
+         lock_guard<mutex> lck(mtx);
+         path = file_path;
       }
-      return oInvalid;
+      return reload();
    }
-}
 
-/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
- |        Iterator related implementations starts      |
- `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
-namespace Icejson
-{
-   Iterator_t::Iterator_t() {}
+   bool SharedDoc_t::reload()
+   {
+      string file_path;
+      {
+         lock_guard<mutex> lck(mtx);
+         file_path = path;
+      }
 
-   Iterator_t::Iterator_t(Node_t *node) :
-      pcur(node) {}
+      Version_t *ver = new Version_t;
+      ver->doc.options = options;
+      if(not ver->doc.parse_file(file_path.data()))
+      {
+         lock_guard<mutex> lck(mtx);
+         err = ver->doc.error;
+         delete ver;
+         return ERR;
+      }
 
-   Iterator_t::operator bool()
-   {
-      return pcur;
+      swap_in(ver);
+      return OK;
    }
 
-   Node_t & Iterator_t::operator * ()
-   {
-      return *pcur;
-   }
-   
-   Iterator_t & Iterator_t::operator ++ ()
+   void SharedDoc_t::swap_in(Version_t *ver)
    {
-      pcur = pcur->pnext;
-      return *this;
+      Version_t *old = pcur.exchange(ver);
+      if(old)
+      {
+         lock_guard<mutex> lck(mtx);
+         old->pnext = retired;
+         retired = old;
+      }
+      reclaim();
    }
 
-   Iterator_t & Iterator_t::operator -- ()
+   /* versions no reader holds are unlinked under the lock and freed
+    * after it, a large tree takes a while to tear down */
+   void SharedDoc_t::reclaim()
    {
-      pcur = pcur->pprev;
-      return *this;
+      Version_t *unused = NULL;
+      {
+         lock_guard<mutex> lck(mtx);
+         for(Version_t **pp = &retired; *pp; )
+         {
+            Version_t *ver = *pp;
+
+            bool pinned = false;
+            for(int I = 0; I < MaxReaders and not pinned; I++)
+               pinned = (ver == slots[I].pver.load());
+
+            if(pinned)
+            {
+               pp = &ver->pnext;
+            }
+            else
+            {
+               *pp = ver->pnext;
+               ver->pnext = unused;
+               unused = ver;
+            }
+         }
+      }
+
+      while(unused)
+      {
+         Version_t *ver = unused;
+         unused = ver->pnext;
+         delete ver;
+      }
    }
 
-   Iterator_t Iterator_t::operator ++ (int)
+   bool SharedDoc_t::watch(const char *file_path, int interval_ms)
    {
-      Iterator_t itr(pcur);
-      pcur = pcur->pnext;
-      return itr;
+      stop();
+
+      long long stamp = file_stamp(file_path);
+      bool ret = load(file_path);
+
+      stopping = false;
+      thd = thread(&SharedDoc_t::watcher, this, interval_ms, stamp);
+
+      return ret;
    }
 
-   Iterator_t Iterator_t::operator -- (int)
+   void SharedDoc_t::watcher(int interval_ms, long long stamp)
    {
-      Iterator_t itr(pcur);
-      pcur = pcur->pprev;
-      return itr;
+      string file_path;
+      {
+         lock_guard<mutex> lck(mtx);
+         file_path = path;
+      }
+
+      for( ; ; )
+      {
+         {
+            unique_lock<mutex> lck(mtx);
+            cv.wait_for(lck, chrono::milliseconds(interval_ms), 
+                  [this] { return stopping; });
+            if(stopping) break;
+         }
+
+         long long cur = file_stamp(file_path.data());
+         if(cur != stamp and -1 != cur)
+         {
+            stamp = cur;
+            reload();
+         }
+         else reclaim();
+      }
    }
 
-   bool Iterator_t::operator == (const Iterator_t &rhs)
+   void SharedDoc_t::stop()
    {
-      return pcur == rhs.pcur;
+      if(not thd.joinable())
+         return;
+
+      {
+         lock_guard<mutex> lck(mtx);
+         stopping = true;
+      }
+      cv.notify_all();
+      thd.join();
    }
 
-   bool Iterator_t::operator != (const Iterator_t &rhs)
+   SharedDoc_t::~SharedDoc_t()
    {
-      return pcur != rhs.pcur;
+      stop();
+      delete pcur.exchange(NULL);
+
+      while(retired)
+      {
+         Version_t *ver = retired;
+         retired = ver->pnext;
+         delete ver;
+      }
    }
 }
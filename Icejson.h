@@ -11,7 +11,21 @@
 
 #pragma once
 
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <cstdint>
 #include <iostream>
+#include <condition_variable>
+
+#ifdef __cpp_impl_coroutine
+#include <coroutine>
+#endif
+
+struct Lexer_t;
 
 namespace Icejson
 {
@@ -24,6 +38,15 @@ namespace Icejson
    struct Error_t;
    struct Parser_t;
    struct Iterator_t;
+   struct SharedDoc_t;
+   struct Stats_t;
+   struct Reader_t;
+   struct Intern_t;
+   struct Arena_t;
+   struct Snapshot_t;
+   struct ParseAwait_t;
+   struct Projection_t;
+   struct Views_t;
 
    /* different value types supported in JSON */
    struct Valtype
@@ -37,12 +60,34 @@ namespace Icejson
          Null     = 'N',
          Array    = 'A',
          Object   = 'O',
+         Packed   = 'P',   /* numeric array stored contiguously */
          Invalid  = 'X'
       };
    };
 
    typedef Valtype::Values Valtype_t;
 
+   /* grammar extensions for parse_string and parse_file, or'ed into
+    * Doc_t::options; the Dup values are not flags but the values of
+    * one two bit field, so at most one of them is or'ed in and without
+    * one repeated member names are all kept and operator [] finds the
+    * first of them */
+   struct ParseOptions
+   {
+      enum Values
+      {
+         Strict         = 0x00,
+         TrailingCommas = 0x01,   /* a comma may follow the last item */
+         DupPolicy      = 0x06,   /* mask of the duplicate name field */
+         DupFirst       = 1 << 1, /* first of repeated names is kept */
+         DupLast        = 2 << 1, /* last of repeated names is kept */
+         DupError       = 3 << 1, /* repeated names are an error */
+         Comments       = 0x08,   /* line and block comments are space */
+         AnyRoot        = 0x10,   /* root may be any value */
+         NanInfinity    = 0x20    /* NaN, Infinity and -Infinity */
+      };
+   };
+
    struct Error_t
    {
       int line;
@@ -51,6 +96,85 @@ namespace Icejson
       string desc;
    };
 
+   /* interned member name, one per distinct name in a table */
+   struct Sym_t
+   {
+      int id;           /* stable for the life of the table */
+      int len;
+      uint64_t hash;    /* of the bytes, reused by Node_t::hash and diff */
+      char str[1];      /* NUL terminated, allocated to fit */
+   };
+
+   /* table of member names mapping their bytes to a Sym_t, safe for
+    * concurrent use when shared; symbols are never removed so the
+    * table has to outlive every document using it */
+   struct Intern_t
+   {
+      Intern_t(bool shared = true);
+
+      const Sym_t * intern(const char *str, int len);
+      const Sym_t * find(const char *str, int len) const;
+
+      int size() const;
+      void clear();     /* only when no document refers to it */
+
+      ~Intern_t();
+
+      private :
+
+      struct Shard_t;
+
+      Intern_t(const Intern_t &);
+      Intern_t & operator = (const Intern_t &);
+
+      bool shared;
+      int nshards;
+      Shard_t *shards;
+      atomic<int> next_id;
+   };
+
+   /* name of an object member, a pointer to its interned symbol;
+    * Node_t::name used to be a string, so the string members code
+    * reads it with are kept, and anything else goes through the
+    * conversion, as in string(node.name).substr(1) */
+   struct Name_t
+   {
+      Name_t() : psym(NULL) {}
+
+      const char * data() const  { return psym ? psym->str : ""; }
+      const char * c_str() const { return data();                }
+      int size() const           { return psym ? psym->len : 0;  }
+      size_t length() const      { return size();                }
+      bool empty() const         { return NULL == psym;          }
+      int id() const             { return psym ? psym->id : -1;  }
+      const Sym_t * sym() const  { return psym;                  }
+
+      char operator [] (int idx) const { return data()[idx]; }
+      operator string () const   { return string(data(), size()); }
+
+      bool operator == (const Name_t &rhs) const;
+      bool operator == (const string &str) const;
+      bool operator == (const char *str) const;
+
+      template <typename T>
+      bool operator != (const T &rhs) const { return not (*this == rhs); }
+
+      private : 
+      
+      const Sym_t *psym;
+
+      friend struct Parser_t;
+      friend struct Helper_t;
+   };
+
+   inline ostream & operator << (ostream &os, const Name_t &name)
+   {
+      return os.write(name.data(), name.size());
+   }
+
+   /* printf formats of the writer, each with one conversion of its
+    * kind; the length is set by the writer, so "%d" and "%x" are fine
+    * for ints, and a format it can not use gives way to the default */
    struct Writer_t
    {
       Writer_t();
@@ -59,22 +183,165 @@ namespace Icejson
       string float_format;
    };
 
+   /* instrumentation filled by parse_string and write, counters
+    * accumulate until reset; collected only when the library is
+    * built with ICEJSON_STATS and enabled is set, otherwise the
+    * instrumentation is compiled out and the counters stay zero */
+   struct Stats_t
+   {
+      Stats_t();
+
+      bool enabled;
+
+      long long bytes;           /* input bytes consumed */
+      long long bytes_written;   /* output bytes produced by write */
+      long long bytes_allocated; /* nodes plus out of line strings */
+
+      long long ints;            /* nodes created by type */
+      long long floats;
+      long long strings;
+      long long bools;
+      long long nulls;
+      long long arrays;
+      long long objects;
+
+      long long strings_copied;  /* string values copied into the tree */
+      long long escapes;         /* escape sequences decoded */
+
+      int max_depth;
+      long long tokens;          /* symbols read by the lexer */
+
+      /* the clock is read per call and not per token, so a parse times
+       * lexing and building together; lex_ns then comes from a second
+       * pass of the lexer alone over the same text, kept out of
+       * parse_ns, and building is parse_ns less lex_ns */
+      long long parse_ns;        /* parse time without teardown */
+      long long lex_ns;          /* the lexer alone, from its own pass */
+      long long free_ns;         /* tearing down replaced trees */
+      long long write_ns;
+
+      void reset();
+
+      /* parses the counters into doc and returns its root */
+      Node_t & export_doc(Doc_t &doc) const;
+   };
+
+   /* key paths kept by a projected parse, such as "user.id" or
+    * "items[*].price"; [*] takes every element of an array and [N]
+    * the one at N, ahead of [*]; a path ending on an array or object
+    * keeps all of it, and names holding '.' or '[' can not be given */
+   struct Projection_t
+   {
+      Projection_t();
+
+      bool add(const char *path);   /* false if path is malformed */
+
+      ~Projection_t();
+
+      struct Step_t;
+
+      private :
+
+      Projection_t(const Projection_t &);
+      Projection_t & operator = (const Projection_t &);
+
+      Step_t *ptop;
+
+      friend struct Doc_t;
+   };
+
    struct Doc_t
    {
       Doc_t();
 
       Error_t error;
+      Stats_t stats;
       Writer_t writer;
 
+      /* store arrays holding only numbers as Valtype::Packed */
+      bool pack_numbers;
+
+      /* ParseOptions flags, Strict unless set */
+      int options;
+
+      enum { KeepNames = 1 << 16 };
+
+      /* shared name table, when NULL the document keeps its own,
+       * which holds on to its names across parses so that documents
+       * of the same shape find them interned, until it grows past
+       * KeepNames and is emptied by the next parse */
+      Intern_t *intern;
+      Intern_t & names();
+
       Node_t & root();
 
       Node_t & parse_file(FILE *);
       Node_t & parse_file(const char *);
       Node_t & parse_string(const char *);
 
+      /* builds only the members and elements on the paths of proj and
+       * the containers leading to them, anything else is stepped over
+       * without being decoded or allocated; duplicate name policies
+       * see only the members kept */
+      Node_t & parse_string(const char *json_str, const Projection_t &proj);
+
+      /* same tree from MessagePack, the root has to be a map */
+      Node_t & parse_msgpack(const char *data, size_t len);
+
+      /* Icejson::validate filling error, the rest of the document is
+       * left alone; options are not looked at */
+      bool validate(const char *json_str, size_t len);
+
+      /* writes the tree as an image which open_snapshot maps without
+       * parsing, the image holds native pointers so it can only be
+       * opened by a build of the same library on the same platform */
+      bool save_snapshot(const char *file_path);
+
+      /* maps an image written by save_snapshot read-only and returns
+       * its root; nodes are read straight from the mapped pages which
+       * every process opening the file shares, the tree is read-only
+       * and stays valid until the document is re-parsed or destroyed */
+      Node_t & open_snapshot(const char *file_path);
+
+      /* applies an RFC 6902 JSON Patch to the tree in place; it stops
+       * at the first operation that fails, leaving the ones before it
+       * applied, and error.offset then counts that operation from 1;
+       * packed arrays it changes become plain arrays and snapshot
+       * trees are refused as they are read-only */
+      bool apply_patch(const char *patch_json);
+      bool apply_patch(Node_t &patch);
+
+      /* parse_file on a pool of at most 4 library threads: reads fd
+       * to its end and parses it there, then calls done on the same
+       * thread; the caller never blocks, the document has to be left
+       * alone and fd open until done runs, and errors are reported
+       * through error as parse_file does. The file is read whole with
+       * plain read() before parsing starts, there is no io_uring and
+       * no parsing while reading; see Icejson::shutdown_async */
+      void parse_async(int fd, void (*done)(Doc_t &doc, void *arg), void *arg);
+
+#ifdef __cpp_impl_coroutine
+      /* co_await doc.parse_async(fd) gives the root, or oInvalid with
+       * error filled; note the thread hop: the rest of the coroutine
+       * runs on the library thread which parsed, not on the one which
+       * awaited, until it hands itself back to an executor of its own */
+      ParseAwait_t parse_async(int fd);
+#endif
+
       ~Doc_t();
 
-      private : Node_t *proot;
+      private : 
+      
+      void reset();
+      Node_t & parse(const char *json_str, const Projection_t::Step_t *pstep);
+
+      Node_t *proot;
+      Intern_t *pnames;  /* own table, used when intern is NULL */
+      Arena_t *parena;   /* string values of the tree */
+      Snapshot_t *psnap; /* mapped image holding the tree, if any */
+      Views_t *pviews;   /* element nodes of packed arrays */
+
+      friend struct Helper_t;
    };
 
    struct Members_t
@@ -87,15 +354,18 @@ namespace Icejson
       Node_t *pparent;
 
       int pcount;
-      string vstr;
       Valtype_t vtype;
 
+      /* structural hash of an array, object or packed array, 0 until
+       * Node_t::hash computes it and again once the node changes */
+      mutable uint64_t vhash;
+
       union
       {
-         int vint;
+         long long vint;
          char vchar;
          bool vbool;
-         float vreal;
+         double vreal;
          struct
          {
             union
@@ -105,6 +375,20 @@ namespace Icejson
             };
             Node_t *vlast;
          };
+         struct
+         {
+            const char *vstr;    /* NUL terminated, owned by the document */
+            int vlen;
+         };
+         struct
+         {
+            union
+            {
+               double *vfloats;
+               long long *vints;
+            };
+            Valtype_t vpacked;   /* Int or Float */
+         };
       };
    };
 
@@ -112,7 +396,7 @@ namespace Icejson
    {
       Node_t();
 
-      string name;
+      Name_t name;
 
       Doc_t & doc() const;
       Node_t & root() const;
@@ -130,15 +414,36 @@ namespace Icejson
 
       Node_t & operator [] (const int idx) const;
       Node_t & operator [] (const char *name) const;
+      Node_t & operator [] (const Sym_t *sym) const;
 
       bool operator != (const Iterator_t &rhs) const;
       bool operator == (const Iterator_t &rhs) const;
 
+      /* integers are held as long long, operator int cuts them down
+       * to int and operator long long gives them whole */
       operator int () const;
       operator char () const;
+      operator long long () const;
       operator float () const;
+      operator double () const;
       operator string () const;
 
+      /* element type of a packed array, Invalid for other nodes */
+      Valtype_t packed_type() const;
+      const double * packed_floats() const;
+      const long long * packed_ints() const;
+
+      /* copies the numbers of a packed or plain array into at most cap
+       * slots and returns how many there are, so a result over cap
+       * means it was cut short; -1 when an element is not a number */
+      int extract(double *buf, int cap) const;
+      int extract(long long *buf, int cap) const;
+      int extract(vector<double> &vec) const;
+      int extract(vector<long long> &vec) const;
+
+      /* on a packed array these and operator [] (int) give element
+       * nodes built the first time the array is walked this way, which
+       * stay valid as long as the array */
       Iterator_t back() const;
       Iterator_t front() const;
       
@@ -146,6 +451,31 @@ namespace Icejson
       int write(char *fh, const char *pad = "   ");
       int write(ostream &os = cout, const char *pad = "   ");
 
+      /* writes at most size bytes including the NUL and returns the
+       * length the whole text needs, so a result of size or more means
+       * it was cut short; pad has no default to keep write(str, 0)
+       * picking the unbounded form */
+      int write(char *str, size_t size, const char *pad);
+
+      /* appends the node as MessagePack, returns the length added */
+      int write_msgpack(string &out);
+
+      /* appends an RFC 6902 JSON Patch turning this node into to and
+       * returns the number of operations; subtrees are paired by their
+       * hashes and a pair hashing the same is compared instead of being
+       * diffed, so a collision can not hide a change */
+      int diff(const Node_t &to, string &patch) const;
+
+      /* structural hash of the value; member order does not count and
+       * numbers hash by value, so 1 and 1.0 agree; containers keep it
+       * until apply_patch changes something below them */
+      uint64_t hash() const;
+
+      /* appends the value with members sorted by name, no white space
+       * and numbers in their shortest form, so equal values give equal
+       * text; returns the length added */
+      int write_canonical(string &out) const;
+
       friend struct Helper_t;
       friend struct Parser_t;
       friend struct Iterator_t;
@@ -170,4 +500,392 @@ namespace Icejson
 
       private : Node_t *pcur;
    };
+
+#ifdef __cpp_impl_coroutine
+   /* awaitable of Doc_t::parse_async(fd), inline so that the library
+    * itself does not have to be built as C++20; await_suspend resumes
+    * the coroutine from the done callback, so on a pool thread */
+   struct ParseAwait_t
+   {
+      Doc_t &doc;
+      int fd;
+
+      bool await_ready() const { return false; }
+
+      void await_suspend(coroutine_handle<> hnd)
+      {
+         doc.parse_async(fd, [](Doc_t &, void *arg)
+               { coroutine_handle<>::from_address(arg).resume(); },
+               hnd.address());
+      }
+
+      Node_t & await_resume() const { return doc.root(); }
+   };
+
+   inline ParseAwait_t Doc_t::parse_async(int fd)
+   {
+      return ParseAwait_t { *this, fd };
+   }
+#endif
+
+   /* document which is re-parsed in the background whenever the
+    * watched file changes; readers pin a version through a guard
+    * and never block, old versions are freed after the last guard
+    * pinning them is released */
+   struct SharedDoc_t
+   {
+      struct Version_t;
+
+      struct Guard_t
+      {
+         Guard_t(Guard_t &&rhs);
+         ~Guard_t();
+
+         /* only on a guard testing true, pin gives an empty one when
+          * nothing is loaded or every reader slot is taken */
+         Doc_t & doc() const;
+         Node_t & root() const;
+
+         operator bool () const;
+
+         private : 
+         
+         Guard_t(atomic<Version_t *> *slot, Version_t *ver);
+         Guard_t(const Guard_t &);
+         Guard_t & operator = (const Guard_t &);
+
+         atomic<Version_t *> *pslot;
+         Version_t *pver;
+
+         friend struct SharedDoc_t;
+      };
+
+      SharedDoc_t();
+
+      /* guards held at once across all threads; pin gives an empty
+       * guard when they are all taken and do not free up after a few
+       * passes, as when one thread holds them all */
+      enum { MaxReaders = 128 };
+
+      int options;   /* ParseOptions of every version */
+
+      bool load(const char *file_path);
+      bool reload();
+
+      bool watch(const char *file_path, int interval_ms = 1000);
+      void stop();
+
+      Guard_t pin() const;
+      Error_t error() const;
+
+      void reclaim();
+
+      ~SharedDoc_t();
+
+      private :
+
+      SharedDoc_t(const SharedDoc_t &);
+      SharedDoc_t & operator = (const SharedDoc_t &);
+
+      void swap_in(Version_t *ver);
+      void watcher(int interval_ms, long long stamp);
+
+      string path;
+      Error_t err;
+
+      thread thd;
+      bool stopping;
+      mutable mutex mtx;      /* guards path, err, retired and stopping */
+      condition_variable cv;
+
+      /* a cache line each, readers pinning on other cores do not
+       * contend for the lines of their neighbours */
+      struct alignas(64) Slot_t
+      {
+         atomic<Version_t *> pver;
+      };
+
+      Version_t *retired;
+      atomic<Version_t *> pcur;
+      mutable Slot_t slots[MaxReaders];
+   };
+
+   /*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+    |    Schema parsers, JSON straight into C++ structs    |
+    `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+
+   /* pull reader handed to the schema parsers, values are read in
+    * document order and nothing is allocated except string values
+    * and names containing escapes; errors are raised internally and
+    * reported through the Error_t given to parse_struct */
+   struct Reader_t
+   {
+      bool begin_object();
+      bool next_key(const char * &key, int &len);
+
+      bool begin_array();
+      bool next_item();
+
+      bool null();   /* consumes null and returns true if present */
+      void skip();   /* skips any value without building it */
+
+      void read(int &val);
+      void read(bool &val);
+      void read(float &val);
+      void read(double &val);
+      void read(string &val);
+      void read(long long &val);
+
+      /* numeric arrays, the span versions fail if cap is exceeded */
+      void read(vector<double> &vec);
+      void read(vector<long long> &vec);
+      size_t read(double *buf, size_t cap);
+      size_t read(long long *buf, size_t cap);
+
+      static bool run(const char *json_str, 
+            void (*fn)(Reader_t &rd, void *arg), void *arg, Error_t &err);
+
+      private :
+
+      Reader_t(Lexer_t &lex);
+
+      Lexer_t &lex;
+      bool first;    /* no member or item read yet in the container */
+      string kbuf;   /* decoded name, used only when it has escapes */
+   };
+
+   /* appends value as JSON text, strings are escaped and NaN and the
+    * infinities, which JSON has no text for, are written as null */
+   void append_value(string &out, int val);
+   void append_value(string &out, bool val);
+   void append_value(string &out, float val);
+   void append_value(string &out, double val);
+   void append_value(string &out, long long val);
+   void append_value(string &out, const string &val);
+
+   template <typename T>
+   struct Field_t
+   {
+      const char *name;
+      int len;
+      void (*read)(Reader_t &rd, T &obj);
+      void (*write)(string &out, const T &obj);
+   };
+
+   /* specialised for each struct by ICEJSON_SCHEMA */
+   template <typename T> struct Schema_t;
+
+   template <typename T> void read_value(Reader_t &rd, T &obj);
+   template <typename T> void write_value(string &out, const T &obj);
+
+   inline void read_value(Reader_t &rd, int &val)       { rd.read(val); }
+   inline void read_value(Reader_t &rd, bool &val)      { rd.read(val); }
+   inline void read_value(Reader_t &rd, float &val)     { rd.read(val); }
+   inline void read_value(Reader_t &rd, double &val)    { rd.read(val); }
+   inline void read_value(Reader_t &rd, string &val)    { rd.read(val); }
+   inline void read_value(Reader_t &rd, long long &val) { rd.read(val); }
+
+   inline void read_value(Reader_t &rd, vector<double> &vec)    { rd.read(vec); }
+   inline void read_value(Reader_t &rd, vector<long long> &vec) { rd.read(vec); }
+
+   inline void write_value(string &out, int val)           { append_value(out, val); }
+   inline void write_value(string &out, bool val)          { append_value(out, val); }
+   inline void write_value(string &out, float val)         { append_value(out, val); }
+   inline void write_value(string &out, double val)        { append_value(out, val); }
+   inline void write_value(string &out, long long val)     { append_value(out, val); }
+   inline void write_value(string &out, const string &val) { append_value(out, val); }
+
+   template <typename T>
+   void read_value(Reader_t &rd, vector<T> &vec)
+   {
+      vec.clear();
+      rd.begin_array();
+      while(rd.next_item())
+      {
+         vec.push_back(T());
+         read_value(rd, vec.back());
+      }
+   }
+
+   template <typename T>
+   void write_value(string &out, const vector<T> &vec)
+   {
+      out += '[';
+      for(size_t I = 0; I < vec.size(); I++)
+      {
+         if(I) out += ',';
+         write_value(out, vec[I]);
+      }
+      out += ']';
+   }
+
+   template <typename T, typename M, M T::*mp>
+   struct Member_t
+   {
+      static void read(Reader_t &rd, T &obj)
+      {
+         if(not rd.null())   /* null leaves the member untouched */
+            read_value(rd, obj.*mp);
+      }
+
+      static void write(string &out, const T &obj)
+      {
+         write_value(out, obj.*mp);
+      }
+   };
+
+   /* field lookup bucketed by name length, the field following the
+    * last match is tried first since members mostly come in order */
+   template <typename T>
+   struct Dispatch_t
+   {
+      enum { MaxLen = 64 };
+
+      const Field_t<T> *fields;
+      int count;
+      int first[MaxLen];   /* first field with a given name length */
+      vector<int> chain;   /* next field with the same name length */
+
+      Dispatch_t()
+      {
+         fields = Schema_t<T>::table(count);
+         chain.assign(count, -1);
+         for(int I = 0; I < MaxLen; I++)
+            first[I] = -1;
+         for(int I = count - 1; I >= 0; I--)
+         {
+            int len = fields[I].len < MaxLen ? fields[I].len : 0;
+            chain[I] = first[len];
+            first[len] = I;
+         }
+      }
+
+      const Field_t<T> * find(const char *key, int len, int &hint) const
+      {
+         if(hint < count and len == fields[hint].len and
+               0 == memcmp(key, fields[hint].name, len))
+            return &fields[hint++];
+
+         for(int I = first[len < MaxLen ? len : 0]; I >= 0; I = chain[I])
+            if(len == fields[I].len and key[0] == fields[I].name[0] and
+                  0 == memcmp(key, fields[I].name, len))
+            {
+               hint = I + 1;
+               return &fields[I];
+            }
+
+         return NULL;
+      }
+
+      static const Dispatch_t & get()
+      {
+         static const Dispatch_t dsp;
+         return dsp;
+      }
+   };
+
+   template <typename T>
+   void read_value(Reader_t &rd, T &obj)
+   {
+      const Dispatch_t<T> &dsp = Dispatch_t<T>::get();
+
+      int len = 0;
+      int hint = 0;
+      const char *key = NULL;
+
+      rd.begin_object();
+      while(rd.next_key(key, len))
+      {
+         const Field_t<T> *fld = dsp.find(key, len, hint);
+         if(fld) fld->read(rd, obj);
+         else rd.skip();
+      }
+   }
+
+   template <typename T>
+   void write_value(string &out, const T &obj)
+   {
+      int count = 0;
+      const Field_t<T> *fields = Schema_t<T>::table(count);
+
+      out += '{';
+      for(int I = 0; I < count; I++)
+      {
+         if(I) out += ',';
+         out += '"';
+         out.append(fields[I].name, fields[I].len);
+         out += "\":";
+         fields[I].write(out, obj);
+      }
+      out += '}';
+   }
+
+   template <typename T>
+   void read_root(Reader_t &rd, void *arg)
+   {
+      read_value(rd, *(T *) arg);
+   }
+
+   /* parses json_str straight into obj, members of obj missing in
+    * the text keep their values and unknown names are skipped */
+   template <typename T>
+   bool parse_struct(const char *json_str, T &obj, Error_t &err)
+   {
+      return Reader_t::run(json_str, &read_root<T>, &obj, err);
+   }
+
+   /* parses a JSON array of numbers straight into vec or buf, for
+    * buf count is the capacity on entry and the size on return */
+   bool parse_array(const char *json_str, vector<double> &vec, Error_t &err);
+   bool parse_array(const char *json_str, vector<long long> &vec, Error_t &err);
+   bool parse_array(const char *json_str, double *buf, size_t &count, Error_t &err);
+   bool parse_array(const char *json_str, long long *buf, size_t &count, Error_t &err);
+
+   /* checks that the first len bytes of json_str are an RFC 8259 JSON
+    * document with an object at the root and valid UTF-8 strings,
+    * without building nodes or allocating; it is strict whatever the
+    * ParseOptions of a parse, so text only they allow fails here, and
+    * strings with lone surrogates pass only as \u escapes, which is
+    * how write gives them back */
+   bool validate(const char *json_str, size_t len, Error_t &err);
+
+   /* waits for the jobs handed to Doc_t::parse_async to finish and
+    * joins the pool threads, which the next parse_async starts again;
+    * it runs at exit as well and must not be called from a done
+    * callback, which runs on one of those threads */
+   void shutdown_async();
+
+   /* appends obj to out as compact JSON, returns the length added */
+   template <typename T>
+   int write_struct(const T &obj, string &out)
+   {
+      size_t len = out.size();
+      write_value(out, obj);
+      return out.size() - len;
+   }
 }
+
+/* describes the members of a struct for parse_struct and write_struct,
+ * use at global scope:
+ *
+ *    ICEJSON_SCHEMA(Point_t, ICEJSON_FIELD(x) ICEJSON_FIELD(y))
+ */
+#define ICEJSON_SCHEMA(type, fields)                                    \
+   namespace Icejson                                                    \
+   {                                                                    \
+      template <> struct Schema_t<type>                                 \
+      {                                                                 \
+         typedef type Self_t;                                           \
+         static const Field_t<type> * table(int &count)                 \
+         {                                                              \
+            static const Field_t<type> arr[] = { fields };              \
+            count = sizeof arr / sizeof *arr;                           \
+            return arr;                                                 \
+         }                                                              \
+      };                                                                \
+   }
+
+#define ICEJSON_FIELD(field)                                            \
+   { #field, sizeof #field - 1,                                         \
+     &Member_t<Self_t, decltype(Self_t::field), &Self_t::field>::read,  \
+     &Member_t<Self_t, decltype(Self_t::field), &Self_t::field>::write },
@@ -0,0 +1,724 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include <algorithm>
+#include <new>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <benchmark/benchmark.h>
+
+#include "Icejson.h"
+#include "corpus.h"
+
+using namespace std;
+using namespace Icejson;
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |     Allocation counting, whole process         |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+static atomic<long long> g_allocs(0);
+
+/* the replacements stay out of line, inlined gcc sees malloc() and
+ * free() meet the new and delete of the callers and warns */
+#define NOINLINE __attribute__((noinline))
+
+NOINLINE void * operator new (size_t size)
+{
+   g_allocs.fetch_add(1, memory_order_relaxed);
+   if(void *ptr = malloc(size ? size : 1))
+      return ptr;
+   throw bad_alloc();
+}
+
+void * operator new [] (size_t size) { return operator new (size); }
+
+NOINLINE void operator delete (void *ptr) noexcept { free(ptr); }
+NOINLINE void operator delete [] (void *ptr) noexcept { free(ptr); }
+NOINLINE void operator delete (void *ptr, size_t) noexcept { free(ptr); }
+NOINLINE void operator delete [] (void *ptr, size_t) noexcept { free(ptr); }
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |     Corpus and helpers                         |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+static size_t corpus_bytes()
+{
+   const char *env = getenv("ICEJSON_BENCH_BYTES");
+   return env ? strtoul(env, NULL, 10) : 1 << 20;
+}
+
+struct Input_t
+{
+   string json;
+   string file;  /* same bytes on disk for parse_file */
+   string snap;  /* parsed tree saved for open_snapshot */
+   string pretty;  /* same document indented, as config files are */
+};
+
+static Input_t inputs[Corpus::ShapeCount];
+
+static int count_nodes(Node_t &node)
+{
+   int count = 1;
+   for(Iterator_t itr = node.front(); itr; ++itr)
+      count += count_nodes(*itr);
+   return count;
+}
+
+/* one member or element per line, indented by two spaces a level up
+ * to MaxIndent levels; deeper levels share the last indent, so nested
+ * input does not grow by the square of its depth */
+static string indent(const string &json)
+{
+   enum { MaxIndent = 16 };
+
+   string out;
+   int lev = 0;
+   bool quoted = false;
+
+   for(size_t I = 0; I < json.size(); I++)
+   {
+      char ch = json[I];
+      if(quoted)
+      {
+         out += ch;
+         if('\\' == ch) out += json[++I];
+         else if('"' == ch) quoted = false;
+         continue;
+      }
+
+      switch(ch)
+      {
+         case '"' : quoted = true;
+                    out += ch;
+                    break;
+
+         case '{' :
+         case '[' : out += ch;
+                    out += '\n';
+                    out.append(2 * std::min(++lev, (int) MaxIndent), ' ');
+                    break;
+
+         case '}' :
+         case ']' : out += '\n';
+                    out.append(2 * std::min(--lev, (int) MaxIndent), ' ');
+                    out += ch;
+                    break;
+
+         case ',' : out += ",\n";
+                    out.append(2 * std::min(lev, (int) MaxIndent), ' ');
+                    break;
+
+         case ':' : out += " : ";
+                    break;
+
+         default  : out += ch;
+      }
+   }
+
+   return out;
+}
+
+/* same document with up to 64 digits spread over it bumped by one;
+ * digits of member names are left alone so no name turns into another */
+static string edited(const string &json)
+{
+   string out = json;
+   size_t step = json.size() / 64 + 1;
+
+   for(size_t I = step / 2; I < out.size(); I += step)
+   {
+      size_t pos = I;
+      for( ; pos < out.size() and pos < I + step; pos++)
+      {
+         if(not isdigit((unsigned char) out[pos]) or '9' == out[pos])
+            continue;
+
+         size_t bgn = pos;
+         while(bgn > 0 and isdigit((unsigned char) out[bgn - 1]))
+            bgn--;
+         if(bgn > 0 and '_' == out[bgn - 1])
+            continue;
+
+         out[pos]++;
+         break;
+      }
+   }
+
+   return out;
+}
+
+static void report(benchmark::State &state, long long allocs, int nodes)
+{
+   struct rusage ru;
+   getrusage(RUSAGE_SELF, &ru);
+
+   state.counters["time/node"] = benchmark::Counter(nodes,
+         benchmark::Counter::kIsIterationInvariantRate | 
+         benchmark::Counter::kInvert);
+   state.counters["allocs/doc"] = benchmark::Counter(allocs,
+         benchmark::Counter::kAvgIterations);
+   state.counters["peak_rss_MB"] = ru.ru_maxrss / 1024.0;
+}
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |     Schema for the twitter corpus              |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+struct User_t
+{
+   long long id;
+   string name;
+   int followers_count;
+   bool verified;
+};
+
+struct Status_t
+{
+   long long id;
+   string text;
+   User_t user;
+   int retweet_count;
+   bool favorited;
+};
+
+struct Timeline_t
+{
+   vector<Status_t> statuses;
+};
+
+ICEJSON_SCHEMA(User_t, ICEJSON_FIELD(id) ICEJSON_FIELD(name) 
+      ICEJSON_FIELD(followers_count) ICEJSON_FIELD(verified))
+ICEJSON_SCHEMA(Status_t, ICEJSON_FIELD(id) ICEJSON_FIELD(text) ICEJSON_FIELD(user)
+      ICEJSON_FIELD(retweet_count) ICEJSON_FIELD(favorited))
+ICEJSON_SCHEMA(Timeline_t, ICEJSON_FIELD(statuses))
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~.
+ |     Benchmarks                                 |
+ `~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+/* parse_string of the compact text, of the indented one or of the
+ * compact one with pack_numbers on */
+enum Form_t { FormCompact, FormPretty, FormPacked };
+
+static void BM_Parse(benchmark::State &state, Corpus::Shape_t shape, Form_t form)
+{
+   Doc_t doc;
+   doc.pack_numbers = FormPacked == form;
+   const string &json = FormPretty == form ? inputs[shape].pretty : inputs[shape].json;
+   int nodes = count_nodes(doc.parse_string(json.data()));
+
+   long long allocs = g_allocs.load();
+   for(auto _ : state)
+   {
+      Node_t &root = doc.parse_string(json.data());
+      benchmark::DoNotOptimize(&root);
+   }
+   allocs = g_allocs.load() - allocs;
+
+   state.SetBytesProcessed(state.iterations() * json.size());
+   report(state, allocs, nodes);
+}
+
+static void BM_Validate(benchmark::State &state, Corpus::Shape_t shape)
+{
+   Doc_t doc;
+   const string &json = inputs[shape].json;
+   int nodes = count_nodes(doc.parse_string(json.data()));
+
+   long long allocs = g_allocs.load();
+   for(auto _ : state)
+   {
+      bool valid = doc.validate(json.data(), json.size());
+      benchmark::DoNotOptimize(valid);
+   }
+   allocs = g_allocs.load() - allocs;
+
+   state.SetBytesProcessed(state.iterations() * json.size());
+   report(state, allocs, nodes);
+}
+
+static void BM_ParseStruct(benchmark::State &state)
+{
+   Error_t err;
+   Timeline_t timeline;
+   const string &json = inputs[Corpus::Twitter].json;
+
+   long long allocs = g_allocs.load();
+   for(auto _ : state)
+   {
+      bool ok = parse_struct(json.data(), timeline, err);
+      benchmark::DoNotOptimize(ok);
+   }
+   allocs = g_allocs.load() - allocs;
+
+   state.SetBytesProcessed(state.iterations() * json.size());
+   state.counters["allocs/doc"] = benchmark::Counter(allocs,
+         benchmark::Counter::kAvgIterations);
+}
+
+static void BM_WriteStruct(benchmark::State &state)
+{
+   Error_t err;
+   Timeline_t timeline;
+   parse_struct(inputs[Corpus::Twitter].json.data(), timeline, err);
+
+   string out;
+   for(auto _ : state)
+   {
+      out.clear();
+      write_struct(timeline, out);
+   }
+
+   state.SetBytesProcessed(state.iterations() * out.size());
+}
+
+static void BM_ParseProjected(benchmark::State &state)
+{
+   /* the fields parse_struct reads from a status, the rest is skipped */
+   Doc_t doc;
+   Projection_t proj;
+   proj.add("statuses[*].id");
+   proj.add("statuses[*].user.id");
+   proj.add("statuses[*].retweet_count");
+   const string &json = inputs[Corpus::Twitter].json;
+   int nodes = count_nodes(doc.parse_string(json.data(), proj));
+
+   long long allocs = g_allocs.load();
+   for(auto _ : state)
+   {
+      Node_t &root = doc.parse_string(json.data(), proj);
+      benchmark::DoNotOptimize(&root);
+   }
+   allocs = g_allocs.load() - allocs;
+
+   state.SetBytesProcessed(state.iterations() * json.size());
+   report(state, allocs, nodes);
+}
+
+static void BM_ParseArray(benchmark::State &state)
+{
+   /* the float array of the numeric corpus on its own */
+   Doc_t doc;
+   vector<double> vec;
+   Node_t &root = doc.parse_string(inputs[Corpus::Numeric].json.data());
+   root["floats"].extract(vec);
+
+   string json = "[";
+   for(size_t I = 0; I < vec.size(); I++)
+   {
+      char num[32];
+      snprintf(num, sizeof num, I ? ",%.6g" : "%.6g", vec[I]);
+      json += num;
+   }
+   json += ']';
+
+   Error_t err;
+   for(auto _ : state)
+   {
+      bool ok = parse_array(json.data(), vec, err);
+      benchmark::DoNotOptimize(ok);
+   }
+
+   state.SetBytesProcessed(state.iterations() * json.size());
+   state.counters["time/value"] = benchmark::Counter(vec.size(),
+         benchmark::Counter::kIsIterationInvariantRate | 
+         benchmark::Counter::kInvert);
+}
+
+static void BM_ParseFile(benchmark::State &state, Corpus::Shape_t shape)
+{
+   Doc_t doc;
+   const Input_t &in = inputs[shape];
+   int nodes = count_nodes(doc.parse_file(in.file.data()));
+
+   long long allocs = g_allocs.load();
+   for(auto _ : state)
+   {
+      Node_t &root = doc.parse_file(in.file.data());
+      benchmark::DoNotOptimize(&root);
+   }
+   allocs = g_allocs.load() - allocs;
+
+   state.SetBytesProcessed(state.iterations() * in.json.size());
+   report(state, allocs, nodes);
+}
+
+struct Wait_t
+{
+   mutex mtx;
+   condition_variable cv;
+   bool done;
+};
+
+static void signal_done(Doc_t &, void *arg)
+{
+   Wait_t &wait = *(Wait_t *) arg;
+   lock_guard<mutex> lck(wait.mtx);
+   wait.done = true;
+   wait.cv.notify_one();
+}
+
+/* same file as parse_file, read and parsed on a library thread while
+ * this one waits, so the difference is the hand over */
+static void BM_ParseAsync(benchmark::State &state, Corpus::Shape_t shape)
+{
+   Doc_t doc;
+   Wait_t wait;
+   const Input_t &in = inputs[shape];
+   int nodes = count_nodes(doc.parse_file(in.file.data()));
+
+   /* g_allocs counts the worker threads too, all their allocations
+    * are done before done is called */
+   long long allocs = g_allocs.load();
+   for(auto _ : state)
+   {
+      int fd = open(in.file.data(), O_RDONLY);
+      if(fd < 0)
+      {
+         state.SkipWithError(("can not open " + in.file).data());
+         break;
+      }
+
+      wait.done = false;
+      doc.parse_async(fd, signal_done, &wait);
+
+      unique_lock<mutex> lck(wait.mtx);
+      wait.cv.wait(lck, [&wait] { return wait.done; });
+      close(fd);
+
+      if(not doc.root())
+      {
+         state.SkipWithError(doc.error.desc.data());
+         break;
+      }
+   }
+   allocs = g_allocs.load() - allocs;
+
+   state.SetBytesProcessed(state.iterations() * in.json.size());
+   report(state, allocs, nodes);
+}
+
+/* maps the saved image, the whole tree is walked so that the time
+ * to fault in its pages is part of what gets measured */
+static void BM_OpenSnapshot(benchmark::State &state, Corpus::Shape_t shape)
+{
+   Doc_t doc;
+   const Input_t &in = inputs[shape];
+   int nodes = count_nodes(doc.open_snapshot(in.snap.data()));
+
+   long long allocs = g_allocs.load();
+   for(auto _ : state)
+   {
+      Node_t &root = doc.open_snapshot(in.snap.data());
+      benchmark::DoNotOptimize(count_nodes(root));
+   }
+   allocs = g_allocs.load() - allocs;
+
+   state.SetBytesProcessed(state.iterations() * in.json.size());
+   report(state, allocs, nodes);
+}
+
+enum Sink_t { SinkFile, SinkChar, SinkStream };
+
+static void BM_Write(benchmark::State &state, Corpus::Shape_t shape, Sink_t sink)
+{
+   Doc_t doc;
+   Node_t &root = doc.parse_string(inputs[shape].json.data());
+   int nodes = count_nodes(root);
+
+   ostringstream sizer;
+   root.write(sizer, NULL);
+   size_t out_len = sizer.str().size();
+
+   FILE *fh = fopen("/dev/null", "w");
+   vector<char> buf(out_len + 1);
+   ostringstream os;
+
+   long long allocs = g_allocs.load();
+   for(auto _ : state)
+   {
+      switch(sink)
+      {
+         case SinkFile   : root.write(fh, NULL);
+                           break;
+         case SinkChar   : root.write(buf.data(), NULL);
+                           break;
+         case SinkStream : os.str(string());
+                           root.write(os, NULL);
+                           break;
+      }
+      benchmark::ClobberMemory();
+   }
+   allocs = g_allocs.load() - allocs;
+   fclose(fh);
+
+   state.SetBytesProcessed(state.iterations() * out_len);
+   report(state, allocs, nodes);
+}
+
+static void BM_WriteMsgpack(benchmark::State &state, Corpus::Shape_t shape)
+{
+   Doc_t doc;
+   Node_t &root = doc.parse_string(inputs[shape].json.data());
+   int nodes = count_nodes(root);
+
+   string out;
+   for(auto _ : state)
+   {
+      out.clear();
+      root.write_msgpack(out);
+   }
+
+   state.SetBytesProcessed(state.iterations() * out.size());
+   report(state, 0, nodes);
+}
+
+static void BM_WriteCanonical(benchmark::State &state, Corpus::Shape_t shape)
+{
+   Doc_t doc;
+   Node_t &root = doc.parse_string(inputs[shape].json.data());
+   int nodes = count_nodes(root);
+
+   string out;
+   for(auto _ : state)
+   {
+      out.clear();
+      root.write_canonical(out);
+   }
+
+   state.SetBytesProcessed(state.iterations() * out.size());
+   report(state, 0, nodes);
+}
+
+/* first hash of a fresh tree, the cached one costs nothing */
+static void BM_Hash(benchmark::State &state, Corpus::Shape_t shape)
+{
+   Doc_t doc;
+   const string &json = inputs[shape].json;
+   int nodes = count_nodes(doc.parse_string(json.data()));
+
+   for(auto _ : state)
+   {
+      state.PauseTiming();
+      Node_t &root = doc.parse_string(json.data());
+      state.ResumeTiming();
+      benchmark::DoNotOptimize(root.hash());
+   }
+
+   state.SetBytesProcessed(state.iterations() * json.size());
+   report(state, 0, nodes);
+}
+
+static void BM_ParseMsgpack(benchmark::State &state, Corpus::Shape_t shape)
+{
+   Doc_t doc;
+   string data;
+   Node_t &root = doc.parse_string(inputs[shape].json.data());
+   int nodes = count_nodes(root);
+   root.write_msgpack(data);
+
+   long long allocs = g_allocs.load();
+   for(auto _ : state)
+   {
+      Node_t &root = doc.parse_msgpack(data.data(), data.size());
+      benchmark::DoNotOptimize(&root);
+   }
+   allocs = g_allocs.load() - allocs;
+
+   state.SetBytesProcessed(state.iterations() * data.size());
+   report(state, allocs, nodes);
+}
+
+static void BM_LookupName(benchmark::State &state, Corpus::Shape_t shape)
+{
+   Doc_t doc;
+   Node_t &root = doc.parse_string(inputs[shape].json.data());
+
+   /* spread the probes over the whole member list */
+   vector<string> names;
+   int step = root.count() / 64 + 1;
+   for(int I = 0; I < root.count(); I += step)
+      names.push_back(string(root[I].name));
+
+   for(auto _ : state)
+      for(size_t I = 0; I < names.size(); I++)
+         benchmark::DoNotOptimize(&root.operator [] (names[I].data()));
+
+   state.SetItemsProcessed(state.iterations() * names.size());
+}
+
+static void BM_LookupIndex(benchmark::State &state, Corpus::Shape_t shape)
+{
+   Doc_t doc;
+   Node_t &root = doc.parse_string(inputs[shape].json.data());
+
+   Node_t *arr = &root;
+   for(Iterator_t itr = root.front(); itr; ++itr)
+      if(Valtype::Array == (*itr).value_type())
+      {
+         arr = &*itr;
+         break;
+      }
+
+   vector<int> idx;
+   int step = arr->count() / 64 + 1;
+   for(int I = 0; I < arr->count(); I += step)
+      idx.push_back(I);
+
+   for(auto _ : state)
+      for(size_t I = 0; I < idx.size(); I++)
+         benchmark::DoNotOptimize(&(*arr)[idx[I]]);
+
+   state.SetItemsProcessed(state.iterations() * idx.size());
+}
+
+static void BM_Diff(benchmark::State &state, Corpus::Shape_t shape)
+{
+   Doc_t from, to;
+   Node_t &root = from.parse_string(inputs[shape].json.data());
+   Node_t &other = to.parse_string(edited(inputs[shape].json).data());
+   int nodes = count_nodes(root);
+
+   string patch;
+   long long allocs = g_allocs.load();
+   for(auto _ : state)
+   {
+      patch.clear();
+      benchmark::DoNotOptimize(root.diff(other, patch));
+   }
+   allocs = g_allocs.load() - allocs;
+
+   state.SetBytesProcessed(state.iterations() * inputs[shape].json.size());
+   report(state, allocs, nodes);
+}
+
+/* applies the patch to the edit and the one back, so the document
+ * is the same at the start of every iteration */
+static void BM_ApplyPatch(benchmark::State &state, Corpus::Shape_t shape)
+{
+   Doc_t doc, to;
+   Node_t &root = doc.parse_string(inputs[shape].json.data());
+   Node_t &other = to.parse_string(edited(inputs[shape].json).data());
+
+   string forth, back;
+   int ops = root.diff(other, forth);
+   ops += other.diff(root, back);
+
+   for(auto _ : state)
+   {
+      bool ok = doc.apply_patch(forth.data()) and doc.apply_patch(back.data());
+      if(not ok)
+      {
+         state.SkipWithError(doc.error.desc.data());
+         break;
+      }
+   }
+
+   state.SetItemsProcessed(state.iterations() * ops);
+}
+
+static void BM_Iterate(benchmark::State &state, Corpus::Shape_t shape)
+{
+   Doc_t doc;
+   Node_t &root = doc.parse_string(inputs[shape].json.data());
+
+   int nodes = 0;
+   for(auto _ : state)
+   {
+      nodes = count_nodes(root);
+      benchmark::DoNotOptimize(nodes);
+   }
+
+   report(state, 0, nodes);
+}
+
+int main(int argc, char **argv)
+{
+   size_t bytes = corpus_bytes();
+   char tmpl[] = "/tmp/icejson_bench_XXXXXX";
+   const char *dir = mkdtemp(tmpl);
+
+   for(int I = 0; I < Corpus::ShapeCount; I++)
+   {
+      Corpus::Shape_t shape = Corpus::Shape_t(I);
+      Input_t &in = inputs[I];
+      in.json = Corpus::generate(shape, bytes);
+
+      Doc_t doc;
+      if(not doc.parse_string(in.json.data()))
+      {
+         fprintf(stderr, "corpus %s does not parse: %s\n", 
+               Corpus::name(shape), doc.error.desc.data());
+         return 1;
+      }
+
+      in.pretty = indent(in.json);
+
+      if(dir)
+      {
+         in.file = string(dir) + "/" + Corpus::name(shape) + ".json";
+         FILE *fh = fopen(in.file.data(), "w");
+         fwrite(in.json.data(), 1, in.json.size(), fh);
+         fclose(fh);
+
+         in.snap = string(dir) + "/" + Corpus::name(shape) + ".snap";
+         doc.save_snapshot(in.snap.data());
+      }
+
+      string name = Corpus::name(shape);
+      benchmark::RegisterBenchmark(("parse_string/" + name).data(), BM_Parse, shape, FormCompact);
+      benchmark::RegisterBenchmark(("parse_pretty/" + name).data(), BM_Parse, shape, FormPretty);
+      benchmark::RegisterBenchmark(("validate/" + name).data(), BM_Validate, shape);
+      if(dir) benchmark::RegisterBenchmark(("parse_file/" + name).data(), BM_ParseFile, shape);
+      /* the parse runs on a library thread, so only wall time shows it */
+      if(dir) benchmark::RegisterBenchmark(("parse_async/" + name).data(), BM_ParseAsync, shape)
+         ->UseRealTime();
+      if(dir) benchmark::RegisterBenchmark(("open_snapshot/" + name).data(), BM_OpenSnapshot, shape);
+      benchmark::RegisterBenchmark(("write_file/" + name).data(), BM_Write, shape, SinkFile);
+      benchmark::RegisterBenchmark(("write_char/" + name).data(), BM_Write, shape, SinkChar);
+      benchmark::RegisterBenchmark(("write_stream/" + name).data(), BM_Write, shape, SinkStream);
+      benchmark::RegisterBenchmark(("write_msgpack/" + name).data(), BM_WriteMsgpack, shape);
+      benchmark::RegisterBenchmark(("parse_msgpack/" + name).data(), BM_ParseMsgpack, shape);
+      benchmark::RegisterBenchmark(("write_canonical/" + name).data(), BM_WriteCanonical, shape);
+      benchmark::RegisterBenchmark(("hash/" + name).data(), BM_Hash, shape);
+      benchmark::RegisterBenchmark(("lookup_name/" + name).data(), BM_LookupName, shape);
+      benchmark::RegisterBenchmark(("lookup_index/" + name).data(), BM_LookupIndex, shape);
+      benchmark::RegisterBenchmark(("iterate/" + name).data(), BM_Iterate, shape);
+      benchmark::RegisterBenchmark(("diff/" + name).data(), BM_Diff, shape);
+      benchmark::RegisterBenchmark(("apply_patch/" + name).data(), BM_ApplyPatch, shape);
+   }
+
+   benchmark::RegisterBenchmark("parse_packed/numeric", BM_Parse, Corpus::Numeric, FormPacked);
+   benchmark::RegisterBenchmark("parse_array/floats", BM_ParseArray);
+   benchmark::RegisterBenchmark("parse_struct/twitter", BM_ParseStruct);
+   benchmark::RegisterBenchmark("write_struct/twitter", BM_WriteStruct);
+   benchmark::RegisterBenchmark("parse_projected/twitter", BM_ParseProjected);
+
+   benchmark::Initialize(&argc, argv);
+   benchmark::RunSpecifiedBenchmarks();
+   benchmark::Shutdown();
+
+   for(int I = 0; dir and I < Corpus::ShapeCount; I++)
+   {
+      unlink(inputs[I].file.data());
+      unlink(inputs[I].snap.data());
+   }
+   if(dir) rmdir(dir);
+
+   return 0;
+}
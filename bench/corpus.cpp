@@ -0,0 +1,208 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "corpus.h"
+
+using namespace std;
+
+namespace Corpus
+{
+   /* xorshift, good enough and the same on every platform */
+   struct Random_t
+   {
+      Random_t(uint64_t seed) : state(seed) {}
+
+      uint64_t next()
+      {
+         state ^= state << 13;
+         state ^= state >> 7;
+         state ^= state << 17;
+         return state;
+      }
+
+      int range(int lo, int hi) { return lo + next() % (hi - lo + 1); }
+
+      uint64_t state;
+   };
+
+   static const char *words[] = 
+   {
+      "lorem", "ipsum", "dolor", "sit", "amet", "json", "parser",
+      "ice", "tweet", "stream", "cache", "config", "route", "edge"
+   };
+
+   static void append(string &out, const char *fmt, long long val)
+   {
+      char buf[64];
+      snprintf(buf, sizeof buf, fmt, val);
+      out += buf;
+   }
+
+   static void append_float(string &out, double val)
+   {
+      char buf[64];
+      snprintf(buf, sizeof buf, "%.6g", val);
+      out += buf;
+   }
+
+   static void append_text(string &out, Random_t &rnd, int nwords, bool escapes)
+   {
+      out += '"';
+      for(int I = 0; I < nwords; I++)
+      {
+         if(I) out += ' ';
+         out += words[rnd.next() % (sizeof words / sizeof *words)];
+         if(escapes) switch(rnd.next() % 8)
+         {
+            case 0 : out += "\\n"; break;
+            case 1 : out += "\\\""; break;
+            case 2 : out += "\\u0041"; break;
+            case 3 : out += "\\t"; break;
+         }
+      }
+      out += '"';
+   }
+
+   static void twitter(string &out, Random_t &rnd, size_t size)
+   {
+      out += "{\"statuses\":[";
+      for(int I = 0; out.size() < size; I++)
+      {
+         if(I) out += ',';
+         append(out, "{\"id\":%lld,", rnd.next() % 1000000000);
+         out += "\"text\":";
+         append_text(out, rnd, rnd.range(5, 25), 1 == I % 3);
+         append(out, ",\"user\":{\"id\":%lld,\"name\":", rnd.next() % 100000);
+         append_text(out, rnd, 2, false);
+         append(out, ",\"followers_count\":%lld,\"verified\":", rnd.range(0, 50000));
+         out += rnd.next() % 2 ? "true" : "false";
+         out += "},\"entities\":{\"hashtags\":[";
+         for(int J = rnd.range(0, 3); J > 0; J--)
+         {
+            out += "{\"text\":";
+            append_text(out, rnd, 1, false);
+            append(out, ",\"indices\":[%lld,", rnd.range(0, 70));
+            append(out, "%lld]}", rnd.range(70, 140));
+            if(J > 1) out += ',';
+         }
+         append(out, "]},\"retweet_count\":%lld,", rnd.range(0, 1000));
+         out += "\"favorited\":false,\"coordinates\":null,\"lang\":\"en\"}";
+      }
+      out += "]}";
+   }
+
+   static void numeric(string &out, Random_t &rnd, size_t size)
+   {
+      out += "{\"ints\":[";
+      for(int I = 0; out.size() < size / 3; I++)
+      {
+         if(I) out += ',';
+         append(out, "%lld", (long long) rnd.range(-1000000, 1000000));
+      }
+      out += "],\"floats\":[";
+      for(int I = 0; out.size() < 2 * size / 3; I++)
+      {
+         if(I) out += ',';
+         append_float(out, (int64_t) rnd.next() / 1e15);
+      }
+      out += "],\"matrix\":[";
+      for(int I = 0; out.size() < size; I++)
+      {
+         out += I ? ",[" : "[";
+         for(int J = 0; J < 16; J++)
+         {
+            if(J) out += ',';
+            append_float(out, rnd.range(0, 100000) / 1000.0);
+         }
+         out += ']';
+      }
+      out += "]}";
+   }
+
+   static void strings(string &out, Random_t &rnd, size_t size)
+   {
+      out += "{\"strings\":[";
+      for(int I = 0; out.size() < size; I++)
+      {
+         if(I) out += ',';
+         append_text(out, rnd, rnd.range(10, 120), true);
+      }
+      out += "]}";
+   }
+
+   static void nested(string &out, Random_t &rnd, size_t size)
+   {
+      const int depth = 256;
+      out += "{\"trees\":[";
+      for(int I = 0; out.size() < size; I++)
+      {
+         if(I) out += ',';
+         for(int J = 0; J < depth; J++)
+            out += J % 2 ? "[" : "{\"n\":";
+         append(out, "%lld", rnd.range(0, 9));
+         for(int J = depth - 1; J >= 0; J--)
+            out += J % 2 ? "]" : "}";
+      }
+      out += "]}";
+   }
+
+   static void wide(string &out, Random_t &rnd, size_t size)
+   {
+      out += '{';
+      for(int I = 0; out.size() < size; I++)
+      {
+         if(I) out += ',';
+         append(out, "\"member_%lld\":", I);
+         switch(I % 3)
+         {
+            case 0  : append(out, "%lld", rnd.range(0, 1000)); break;
+            case 1  : append_text(out, rnd, 1, false); break;
+            default : out += "true";
+         }
+      }
+      out += '}';
+   }
+
+   const char * name(Shape_t shape)
+   {
+      switch(shape)
+      {
+         case Twitter : return "twitter";
+         case Numeric : return "numeric";
+         case Strings : return "strings";
+         case Nested  : return "nested";
+         case Wide    : return "wide";
+         default      : return "invalid";
+      }
+   }
+
+   string generate(Shape_t shape, size_t approx_bytes)
+   {
+      string out;
+      Random_t rnd(0x1CE150A + shape);
+      out.reserve(approx_bytes + 4096);
+
+      switch(shape)
+      {
+         case Twitter : twitter(out, rnd, approx_bytes); break;
+         case Numeric : numeric(out, rnd, approx_bytes); break;
+         case Strings : strings(out, rnd, approx_bytes); break;
+         case Nested  : nested(out, rnd, approx_bytes);  break;
+         case Wide    : wide(out, rnd, approx_bytes);    break;
+         default      : break;
+      }
+
+      return out;
+   }
+}
@@ -0,0 +1,33 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#pragma once
+
+#include <string>
+
+/* synthetic documents of different shapes used by the benchmarks,
+ * the generator is seeded so every run sees the same bytes */
+namespace Corpus
+{
+   enum Shape_t
+   {
+      Twitter,    /* arrays of mixed records, like a timeline API */
+      Numeric,    /* ints, floats and number matrices */
+      Strings,    /* long strings with escapes and unicode */
+      Nested,     /* objects and arrays nested hundreds deep */
+      Wide,       /* one object with thousands of members */
+      ShapeCount
+   };
+
+   const char * name(Shape_t shape);
+
+   std::string generate(Shape_t shape, size_t approx_bytes);
+}
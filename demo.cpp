@@ -35,6 +35,8 @@ void PrintJson(Node_t &node)
          case Valtype::Object : fprintf(stderr, "(%d)\n", ref.count());
                                 PrintJson(ref);
                                 break;
+         default              : cerr << endl;
+                                break;
       }
    }
    return;
@@ -0,0 +1,87 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "Icejson.h"
+
+/* shared parts of the fuzz targets: a reference parser used as the
+ * oracle, the comparison of its values with Node_t trees and a time
+ * budget which catches inputs that parse in super-linear time */
+namespace Fuzz
+{
+   using std::string;
+   using std::vector;
+
+   /* a value as the reference parser reads it, arrays leave names
+    * empty and packed arrays of a tree are expanded into items */
+   struct Ref_t
+   {
+      Icejson::Valtype_t vtype;
+      bool vbool;
+      long long vint;
+      double vreal;
+      string vstr;
+      vector<string> names;
+      vector<Ref_t> items;
+   };
+
+   /* the known departures of Icejson from RFC 8259, or'ed into the
+    * allow argument of ref_parse; each target switches on just the
+    * ones the call it checks is meant to have, the rest stay errors */
+   struct Deviation
+   {
+      enum Values
+      {
+         None         = 0x00,
+         ObjectRoot   = 0x01,   /* the root has to be an object */
+         LeadingZeros = 0x02,   /* integer parts such as 007 */
+         RawControls  = 0x04,   /* bytes below 0x20 unescaped in strings */
+         RawBytes     = 0x08,   /* string bytes without a UTF-8 check */
+
+         /* what Doc_t::validate and Doc_t::parse_string take */
+         Validate     = ObjectRoot,
+         ParseString  = ObjectRoot | LeadingZeros | RawControls | RawBytes
+      };
+   };
+
+   /* reads the len bytes of text as one RFC 8259 document with the
+    * deviations in allow, false when rejected; integers past long long
+    * are read as floats and a \u escape of an unpaired surrogate is
+    * kept in its 3 byte form, as Node_t holds them */
+   bool ref_parse(const char *text, size_t len, int allow, Ref_t &out);
+
+   void from_node(Icejson::Node_t &node, Ref_t &out);
+
+   /* where the first difference is, empty when both are the same;
+    * floats have to match bit for bit */
+   string compare(const Ref_t &lhs, const Ref_t &rhs);
+
+   /* reports a finding and aborts, so that the engine keeps the input */
+   void fail(const char *target, const char *what, const string &detail);
+
+   /* CPU time of one call against ICEJSON_FUZZ_NS_PER_BYTE (10000 by
+    * default, loose enough for sanitizer builds) for each input byte
+    * on top of a fixed 50 ms allowance */
+   struct Budget_t
+   {
+      Budget_t(size_t len);
+      void check(const char *target, const char *what);
+
+      size_t len;
+      uint64_t start;
+   };
+}
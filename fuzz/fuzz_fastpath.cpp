@@ -0,0 +1,113 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include <string.h>
+#include <set>
+
+#include "fuzz.h"
+
+using namespace Fuzz;
+using namespace Icejson;
+
+static const char *target = "fuzz_fastpath";
+
+/* the paths which do the same job as parse_string another way, each
+ * checked against the plain parse or the reference parser: validate,
+ * packed numbers, projection and MessagePack input */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+   string text((const char *) data, size);
+   Budget_t budget(size);
+
+   /* validate reads len bytes, NULs included */
+   Doc_t doc;
+   Ref_t strict;
+   bool valid = ref_parse(text.data(), size, Deviation::Validate, strict);
+   if(valid != doc.validate(text.data(), size))
+      fail(target, valid ? "validate rejects a valid document" :
+            "validate accepts an invalid document", doc.error.desc);
+   budget.check(target, "validate");
+
+   Ref_t expect, got;
+   Node_t &root = doc.parse_string(text.c_str());
+   budget.check(target, "parse_string");
+   if(root)
+      from_node(root, expect);
+   else if(valid)
+      fail(target, "parse_string rejects what validate takes", doc.error.desc);
+
+   Doc_t packed;
+   packed.pack_numbers = true;
+   Node_t &proot = packed.parse_string(text.c_str());
+   budget.check(target, "pack_numbers");
+   if(proot.valid() != root.valid())
+      fail(target, "pack_numbers changes what is accepted", packed.error.desc);
+   if(proot)
+   {
+      string lhs, rhs;
+      root.write_canonical(lhs);
+      proot.write_canonical(rhs);
+      if(lhs != rhs or root.hash() != proot.hash())
+         fail(target, "pack_numbers changes the values", lhs + "\n" + rhs);
+   }
+
+   /* the first members by name, the rest has to be skipped alike */
+   std::set<string> keep;
+   Projection_t proj;
+   proj.add("\x01" "none");
+   keep.insert("\x01" "none");
+   for(size_t I = 0; root and I < expect.names.size() and keep.size() < 3; I++)
+      if(strlen(expect.names[I].c_str()) == expect.names[I].size() and
+            proj.add(expect.names[I].c_str()))
+         keep.insert(expect.names[I]);
+
+   Doc_t part;
+   Node_t &sub = part.parse_string(text.c_str(), proj);
+   budget.check(target, "projection");
+   if(sub.valid() != root.valid())
+      fail(target, "projection changes what is accepted", part.error.desc);
+   if(sub)
+   {
+      Ref_t want;
+      want.vtype = Valtype::Object;
+      for(size_t I = 0; I < expect.names.size(); I++)
+         if(keep.count(expect.names[I]))
+         {
+            want.names.push_back(expect.names[I]);
+            want.items.push_back(expect.items[I]);
+         }
+      from_node(sub, got);
+      string diff = compare(want, got);
+      if(not diff.empty())
+         fail(target, "projection differs from the plain parse", diff);
+   }
+
+   /* any bytes as MessagePack, what parses has to write back alike */
+   Doc_t unpack;
+   Node_t &mroot = unpack.parse_msgpack(text.data(), size);
+   budget.check(target, "parse_msgpack");
+   if(mroot)
+   {
+      from_node(mroot, expect);
+      string pack;
+      mroot.write_msgpack(pack);
+      Doc_t again;
+      Node_t &back = again.parse_msgpack(pack.data(), pack.size());
+      if(not back)
+         fail(target, "written MessagePack does not parse", again.error.desc);
+      from_node(back, got);
+      string diff = compare(expect, got);
+      if(not diff.empty())
+         fail(target, "MessagePack round trip differs", diff);
+   }
+
+   return 0;
+}
@@ -0,0 +1,72 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include <string.h>
+
+#include "fuzz.h"
+
+using namespace Fuzz;
+using namespace Icejson;
+
+/* parse_string against the reference parser with the deviations of
+ * parse_string: both have to accept or reject the same inputs and
+ * build the same values, and the grammar extensions may only add to
+ * that, AnyRoot lifting the object root rule */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+   static const char *target = "fuzz_parse";
+
+   /* parse_string reads up to the first NUL, so does the oracle */
+   string text((const char *) data, size);
+   size_t len = strlen(text.c_str());
+
+   Ref_t expect, got;
+   bool valid = ref_parse(text.c_str(), len, Deviation::ParseString, expect);
+
+   Doc_t doc;
+   Budget_t budget(size);
+   Node_t &root = doc.parse_string(text.c_str());
+   budget.check(target, "parse_string");
+
+   if(valid != root.valid())
+      fail(target, valid ? "parse_string rejects a valid document" :
+            "parse_string accepts an invalid document", doc.error.desc);
+
+   if(valid)
+   {
+      from_node(root, got);
+      string diff = compare(expect, got);
+      if(not diff.empty())
+         fail(target, "parse_string and the oracle differ", diff);
+   }
+   else if(doc.error.desc.empty() or doc.error.offset < 1 or
+         (size_t) doc.error.offset > len + 1)
+      fail(target, "error is not filled", doc.error.desc);
+
+   if(not ref_parse(text.c_str(), len, Deviation::ParseString & ~Deviation::ObjectRoot, expect))
+      return 0;
+
+   Doc_t ext;
+   ext.options = ParseOptions::Comments | ParseOptions::TrailingCommas |
+      ParseOptions::AnyRoot | ParseOptions::NanInfinity;
+   Node_t &same = ext.parse_string(text.c_str());
+   budget.check(target, "parse_string with options");
+
+   if(not same)
+      fail(target, "grammar extensions reject a valid document", ext.error.desc);
+
+   from_node(same, got);
+   string diff = compare(expect, got);
+   if(not diff.empty())
+      fail(target, "grammar extensions change the values", diff);
+
+   return 0;
+}
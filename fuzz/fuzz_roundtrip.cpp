@@ -0,0 +1,96 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include <string.h>
+
+#include "fuzz.h"
+
+using namespace Fuzz;
+using namespace Icejson;
+
+static const char *target = "fuzz_roundtrip";
+
+static void same_tree(const char *what, const Ref_t &expect, Node_t &node)
+{
+   Ref_t got;
+   from_node(node, got);
+   string diff = compare(expect, got);
+   if(not diff.empty())
+      fail(target, what, diff);
+}
+
+/* write into a caller buffer, compact and padded, then parse again:
+ * the bounded form has to report the full length, stop at its size
+ * and give the same text as the unbounded one; MessagePack has to
+ * give back the same tree as well */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+   string text((const char *) data, size);
+
+   Doc_t doc;
+   Budget_t budget(size);
+   Node_t &root = doc.parse_string(text.c_str());
+   budget.check(target, "parse_string");
+   if(not root)
+      return 0;
+
+   /* every float keeps its bits and its dot through the text */
+   doc.writer.float_format = "%#.17g";
+
+   Ref_t expect;
+   from_node(root, expect);
+
+   const char *pads[] = { NULL, "   " };
+   for(const char *pad : pads)
+   {
+      int need = root.write((char *) NULL, 0, pad);
+      vector<char> out(need + 1, 'x');
+      if(need != root.write(out.data(), out.size(), pad) or
+            strlen(out.data()) != (size_t) need)
+         fail(target, "bounded write gives a different length", out.data());
+
+      vector<char> plain(need + 1, 'x');
+      if(need != root.write(plain.data(), pad) or 0 != strcmp(plain.data(), out.data()))
+         fail(target, "bounded and unbounded write differ", out.data());
+
+      /* a short buffer is cut off and terminated, never overrun */
+      size_t cut = (size ? data[0] : 0) % (need + 1);
+      vector<char> part(cut + 1, 'x');
+      if(need != root.write(part.data(), cut, pad) or
+            (cut and (strlen(part.data()) != cut - 1 or
+                      0 != strncmp(part.data(), out.data(), cut - 1))) or
+            'x' != part[cut])
+         fail(target, "bounded write overruns its buffer", part.data());
+      budget.check(target, "write");
+
+      Doc_t again;
+      again.options = ParseOptions::NanInfinity;
+      Node_t &back = again.parse_string(out.data());
+      budget.check(target, "parse_string of the written text");
+      if(not back)
+         fail(target, "written text does not parse", again.error.desc + "\n" + out.data());
+      same_tree("written text parses to another tree", expect, back);
+
+      if(root.hash() != back.hash())
+         fail(target, "equal trees hash differently", out.data());
+   }
+
+   string pack;
+   root.write_msgpack(pack);
+   Doc_t unpack;
+   Node_t &back = unpack.parse_msgpack(pack.data(), pack.size());
+   budget.check(target, "MessagePack");
+   if(not back)
+      fail(target, "written MessagePack does not parse", unpack.error.desc);
+   same_tree("MessagePack parses to another tree", expect, back);
+
+   return 0;
+}
@@ -0,0 +1,489 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fuzz.h"
+
+using namespace Icejson;
+
+namespace Fuzz
+{
+   /* the reference parser, one byte at a time and bounds checked
+    * against len, written to be obviously right rather than fast.
+    * It follows RFC 8259 and relaxes only the rules named in allow;
+    * nesting past MaxDepth is an error as section 9 lets it be */
+   struct Oracle_t
+   {
+      enum { MaxDepth = 1024 };
+
+      const char *text;
+      size_t len;
+      size_t pos;
+      int depth;
+      int allow;
+
+      int peek() const { return pos < len ? (unsigned char) text[pos] : -1; }
+
+      static bool digit(int ch) { return '0' <= ch and ch <= '9'; }
+
+      void space()
+      {
+         while(' ' == peek() or '\t' == peek() or '\n' == peek() or '\r' == peek())
+            pos++;
+      }
+
+      bool word(const char *lit);
+      bool hex4(unsigned &code);
+      bool utf8();
+      bool str(string &out);
+      bool number(Ref_t &out);
+      bool value(Ref_t &out);
+   };
+
+   static void put_utf8(string &out, unsigned code)
+   {
+      if(code < 0x80)
+         out += (char) code;
+      else if(code < 0x800)
+      {
+         out += (char) (0xC0 | (code >> 6));
+         out += (char) (0x80 | (code & 0x3F));
+      }
+      else if(code < 0x10000)
+      {
+         out += (char) (0xE0 | (code >> 12));
+         out += (char) (0x80 | ((code >> 6) & 0x3F));
+         out += (char) (0x80 | (code & 0x3F));
+      }
+      else
+      {
+         out += (char) (0xF0 | (code >> 18));
+         out += (char) (0x80 | ((code >> 12) & 0x3F));
+         out += (char) (0x80 | ((code >> 6) & 0x3F));
+         out += (char) (0x80 | (code & 0x3F));
+      }
+   }
+
+   bool Oracle_t::word(const char *lit)
+   {
+      size_t n = strlen(lit);
+      if(len - pos < n or 0 != memcmp(text + pos, lit, n))
+         return false;
+      pos += n;
+      return true;
+   }
+
+   /* the four hex digits after "\u", pos is left past them */
+   bool Oracle_t::hex4(unsigned &code)
+   {
+      if(len - pos < 4)
+         return false;
+
+      code = 0;
+      for(int I = 0; I < 4; I++)
+      {
+         int ch = text[pos++];
+         int val = digit(ch) ? ch - '0' :
+            ('a' <= ch and ch <= 'f') ? ch - 'a' + 10 :
+            ('A' <= ch and ch <= 'F') ? ch - 'A' + 10 : -1;
+         if(val < 0)
+            return false;
+         code = code * 16 + val;
+      }
+
+      return true;
+   }
+
+   /* one well formed UTF-8 sequence, decoded to its code point and
+    * checked for overlong forms, surrogates and the upper bound */
+   bool Oracle_t::utf8()
+   {
+      unsigned lead = peek();
+      int n = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 0;
+      if(0 == n or lead >= 0xF8 or len - pos < (size_t) n)
+         return false;
+
+      unsigned code = lead & (0x7F >> n);
+      for(int I = 1; I < n; I++)
+      {
+         unsigned ch = (unsigned char) text[pos + I];
+         if(0x80 != (ch & 0xC0))
+            return false;
+         code = (code << 6) | (ch & 0x3F);
+      }
+
+      static const unsigned least[] = { 0, 0, 0x80, 0x800, 0x10000 };
+      if(code < least[n] or code > 0x10FFFF or (0xD800 <= code and code < 0xE000))
+         return false;
+
+      pos += n;
+      return true;
+   }
+
+   bool Oracle_t::str(string &out)
+   {
+      pos++;   /* opening quote */
+
+      while(pos < len)
+      {
+         unsigned char ch = text[pos];
+
+         if('"' == ch)
+         {
+            pos++;
+            return true;
+         }
+
+         if('\\' != ch)
+         {
+            if(ch < 0x20 and not (allow & Deviation::RawControls))
+               return false;
+            if(ch >= 0x80 and not (allow & Deviation::RawBytes))
+            {
+               size_t bgn = pos;
+               if(not utf8())
+                  return false;
+               out.append(text + bgn, pos - bgn);
+               continue;
+            }
+            out += (char) ch;
+            pos++;
+            continue;
+         }
+
+         if(++pos >= len)
+            return false;
+
+         unsigned code = 0;
+         switch(text[pos++])
+         {
+            case '"'  : out += '"';  break;
+            case '\\' : out += '\\'; break;
+            case '/'  : out += '/';  break;
+            case 'b'  : out += '\b'; break;
+            case 'f'  : out += '\f'; break;
+            case 'n'  : out += '\n'; break;
+            case 'r'  : out += '\r'; break;
+            case 't'  : out += '\t'; break;
+
+            case 'u'  : if(not hex4(code))
+                           return false;
+                        if(0xD800 <= code and code < 0xDC00 and
+                              len - pos >= 2 and 0 == memcmp(text + pos, "\\u", 2))
+                        {
+                           size_t high = pos;
+                           unsigned low = 0;
+                           pos += 2;
+                           if(not hex4(low))
+                              return false;
+                           if(0xDC00 <= low and low < 0xE000)
+                              code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                           else
+                              pos = high;
+                        }
+                        put_utf8(out, code);
+                        break;
+
+            default   : return false;
+         }
+      }
+
+      return false;
+   }
+
+   bool Oracle_t::number(Ref_t &out)
+   {
+      size_t bgn = pos;
+      bool real = false;
+
+      if('-' == peek())
+         pos++;
+      if(not digit(peek()))
+         return false;
+      if(not (allow & Deviation::LeadingZeros) and '0' == peek() and digit((pos + 1 < len) ? text[pos + 1] : -1))
+         return false;
+      while(digit(peek()))
+         pos++;
+
+      /* a dot without digits ends the number, what follows then fails */
+      if('.' == peek() and pos + 1 < len and digit(text[pos + 1]))
+      {
+         real = true;
+         for(pos++; digit(peek()); pos++);
+      }
+
+      if('e' == peek() or 'E' == peek())
+      {
+         real = true;
+         pos++;
+         if('+' == peek() or '-' == peek())
+            pos++;
+         if(not digit(peek()))
+            return false;
+         while(digit(peek()))
+            pos++;
+      }
+
+      /* an integer past long long is kept as the nearest float */
+      string num(text + bgn, pos - bgn);
+      if(not real)
+      {
+         errno = 0;
+         out.vtype = Valtype::Int;
+         out.vint = strtoll(num.c_str(), NULL, 10);
+         real = ERANGE == errno;
+      }
+      if(real)
+      {
+         out.vtype = Valtype::Float;
+         out.vreal = strtod(num.c_str(), NULL);
+      }
+
+      return true;
+   }
+
+   bool Oracle_t::value(Ref_t &out)
+   {
+      int open = peek();
+
+      switch(open)
+      {
+         case '"' : out.vtype = Valtype::String;
+                    return str(out.vstr);
+
+         case '-' : case '0' : case '1' : case '2' : case '3' : case '4' :
+         case '5' : case '6' : case '7' : case '8' : case '9' :
+                    return number(out);
+
+         case 't' : out.vtype = Valtype::Bool;
+                    out.vbool = true;
+                    return word("true");
+
+         case 'f' : out.vtype = Valtype::Bool;
+                    out.vbool = false;
+                    return word("false");
+
+         case 'n' : out.vtype = Valtype::Null;
+                    return word("null");
+
+         case '[' : out.vtype = Valtype::Array;
+                    break;
+
+         case '{' : out.vtype = Valtype::Object;
+                    break;
+
+         default  : return false;
+      }
+
+      if(++depth > MaxDepth)
+         return false;
+
+      int close = ('[' == open) ? ']' : '}';
+      pos++;
+      space();
+      if(close == peek())
+      {
+         pos++;
+         depth--;
+         return true;
+      }
+
+      for( ; ; )
+      {
+         string name;
+         if('{' == open)
+         {
+            if('"' != peek() or not str(name))
+               return false;
+            space();
+            if(':' != peek())
+               return false;
+            pos++;
+            space();
+         }
+
+         out.names.push_back(name);
+         out.items.push_back(Ref_t());
+         if(not value(out.items.back()))
+            return false;
+         space();
+
+         if(close == peek())
+            break;
+         if(',' != peek())
+            return false;
+         pos++;
+         space();
+      }
+
+      pos++;
+      depth--;
+      return true;
+   }
+
+   bool ref_parse(const char *text, size_t len, int allow, Ref_t &out)
+   {
+      Oracle_t orc = { text, len, 0, 0, allow };
+      out = Ref_t();
+
+      orc.space();
+      if((allow & Deviation::ObjectRoot) and '{' != orc.peek())
+         return false;
+      if(not orc.value(out))
+         return false;
+      orc.space();
+
+      return orc.pos == len;
+   }
+
+   void from_node(Node_t &node, Ref_t &out)
+   {
+      out = Ref_t();
+      out.vtype = node.value_type();
+
+      switch(out.vtype)
+      {
+         case Valtype::Int    : out.vint = (long long) node;
+                                break;
+
+         case Valtype::Float  : out.vreal = (double) node;
+                                break;
+
+         case Valtype::String : out.vstr = (string) node;
+                                break;
+
+         case Valtype::Bool   : out.vbool = (char) node;
+                                break;
+
+         case Valtype::Packed : out.vtype = Valtype::Array;
+                                for(int I = 0; I < node.count(); I++)
+                                {
+                                   Ref_t num;
+                                   if(node.packed_ints())
+                                   {
+                                      num.vtype = Valtype::Int;
+                                      num.vint = node.packed_ints()[I];
+                                   }
+                                   else
+                                   {
+                                      num.vtype = Valtype::Float;
+                                      num.vreal = node.packed_floats()[I];
+                                   }
+                                   out.names.push_back(string());
+                                   out.items.push_back(num);
+                                }
+                                break;
+
+         case Valtype::Array  :
+         case Valtype::Object : for(Iterator_t itr = node.front(); Node_t &ref = *itr; ++itr)
+                                {
+                                   out.names.push_back(ref.name);
+                                   out.items.push_back(Ref_t());
+                                   from_node(ref, out.items.back());
+                                }
+                                break;
+
+         default              : break;
+      }
+   }
+
+   string compare(const Ref_t &lhs, const Ref_t &rhs)
+   {
+      char buf[96];
+
+      if(lhs.vtype != rhs.vtype)
+      {
+         snprintf(buf, sizeof buf, ": type %d against %d", lhs.vtype, rhs.vtype);
+         return buf;
+      }
+
+      switch(lhs.vtype)
+      {
+         case Valtype::Int    : if(lhs.vint == rhs.vint)
+                                   return string();
+                                snprintf(buf, sizeof buf, ": %lld against %lld", lhs.vint, rhs.vint);
+                                return buf;
+
+         case Valtype::Float  : if(0 == memcmp(&lhs.vreal, &rhs.vreal, sizeof(double)))
+                                   return string();
+                                snprintf(buf, sizeof buf, ": %.17g against %.17g", lhs.vreal, rhs.vreal);
+                                return buf;
+
+         case Valtype::String : if(lhs.vstr == rhs.vstr)
+                                   return string();
+                                return ": \"" + lhs.vstr + "\" against \"" + rhs.vstr + "\"";
+
+         case Valtype::Bool   : return lhs.vbool == rhs.vbool ? string() : ": bool";
+
+         case Valtype::Array  :
+         case Valtype::Object : if(lhs.items.size() != rhs.items.size())
+                                {
+                                   snprintf(buf, sizeof buf, ": %zu items against %zu",
+                                         lhs.items.size(), rhs.items.size());
+                                   return buf;
+                                }
+                                for(size_t I = 0; I < lhs.items.size(); I++)
+                                {
+                                   snprintf(buf, sizeof buf, "/%zu", I);
+                                   if(lhs.names[I] != rhs.names[I])
+                                      return buf + (": name \"" + lhs.names[I] +
+                                            "\" against \"" + rhs.names[I] + "\"");
+                                   string diff = compare(lhs.items[I], rhs.items[I]);
+                                   if(not diff.empty())
+                                      return buf + diff;
+                                }
+                                return string();
+
+         default              : return string();
+      }
+   }
+
+   void fail(const char *target, const char *what, const string &detail)
+   {
+      fprintf(stderr, "\n%s : %s\n%s\n", target, what, detail.c_str());
+      fflush(stderr);
+      abort();
+   }
+
+   /* CPU time of the thread, so other load on the machine does not count */
+   static uint64_t now_ns()
+   {
+      struct timespec ts;
+      clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+      return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+   }
+
+   Budget_t::Budget_t(size_t len) : len(len), start(now_ns()) {}
+
+   void Budget_t::check(const char *target, const char *what)
+   {
+      static const uint64_t per_byte = getenv("ICEJSON_FUZZ_NS_PER_BYTE") ?
+         strtoull(getenv("ICEJSON_FUZZ_NS_PER_BYTE"), NULL, 10) : 10000;
+
+      uint64_t took = now_ns() - start;
+      uint64_t allowed = 50000000 + per_byte * len;
+
+      if(took > allowed)
+      {
+         char buf[128];
+         snprintf(buf, sizeof buf, "%zu bytes took %llu us, the budget is %llu us",
+               len, (unsigned long long) took / 1000, (unsigned long long) allowed / 1000);
+         fail(target, what, buf);
+      }
+
+      start = now_ns();
+   }
+}
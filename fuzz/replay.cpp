@@ -0,0 +1,208 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+
+#if defined(__SANITIZE_ADDRESS__)
+   #include <sanitizer/common_interface_defs.h>
+   #include <sanitizer/lsan_interface.h>
+#endif
+
+using namespace std;
+
+/* main for compilers without libFuzzer: every file and every file
+ * of a directory given is run once, then -runs=N more inputs are
+ * made by mutating them (no coverage feedback, just random edits
+ * with JSON tokens); the input being run when something fails is
+ * saved as crash-replay, -detect_leaks=1 checks for leaks after
+ * every input instead of once at exit */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+/* the input being run, NULL outside of a run */
+static const string *current;
+static bool detect_leaks;
+
+static void save_current()
+{
+   if(NULL == current)
+      return;
+
+   int fd = open("crash-replay", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if(fd < 0)
+      return;
+   if(write(fd, current->data(), current->size()) < 0) {}
+   close(fd);
+   const char msg[] = "input saved as crash-replay\n";
+   if(write(2, msg, sizeof msg - 1) < 0) {}
+}
+
+static void on_abort(int)
+{
+   save_current();
+   signal(SIGABRT, SIG_DFL);
+   raise(SIGABRT);
+}
+
+static bool read_file(const string &path, vector<string> &inputs)
+{
+   FILE *fh = fopen(path.c_str(), "rb");
+   if(NULL == fh)
+      return false;
+
+   string data;
+   char buf[4096];
+   for(size_t len; (len = fread(buf, 1, sizeof buf, fh)) > 0; )
+      data.append(buf, len);
+   fclose(fh);
+
+   inputs.push_back(data);
+   return true;
+}
+
+static void read_path(const string &path, vector<string> &inputs)
+{
+   struct stat st;
+   if(0 != stat(path.c_str(), &st))
+      return;
+
+   if(not S_ISDIR(st.st_mode))
+   {
+      read_file(path, inputs);
+      return;
+   }
+
+   DIR *dir = opendir(path.c_str());
+   for(struct dirent *ent; dir and (ent = readdir(dir)); )
+      if('.' != ent->d_name[0])
+         read_path(path + "/" + ent->d_name, inputs);
+   if(dir) closedir(dir);
+}
+
+/* xorshift, seeded from the command line so a run can be repeated */
+static uint64_t rnd_state = 88172645463325252ULL;
+
+static size_t rnd(size_t lim)
+{
+   rnd_state ^= rnd_state << 13;
+   rnd_state ^= rnd_state >> 7;
+   rnd_state ^= rnd_state << 17;
+   return lim ? rnd_state % lim : 0;
+}
+
+static void run(const string &data)
+{
+   current = &data;
+   LLVMFuzzerTestOneInput((const uint8_t *) data.data(), data.size());
+#if defined(__SANITIZE_ADDRESS__)
+   if(detect_leaks and __lsan_do_recoverable_leak_check())
+   {
+      save_current();
+      exit(1);
+   }
+#endif
+   current = NULL;
+}
+
+static void mutate(string &data, size_t max_len)
+{
+   static const char *tokens[] =
+   {
+      "{", "}", "[", "]", ",", ":", "\"", "\\", "\\u", "\\ud83d", "\\udc00",
+      "0", "-", ".", "e", "E+", "1e400", "9223372036854775808", "true", "false",
+      "null", " ", "\n", "\t", "\"a\":", "{\"a\":[1,2.5,\"x\"]}", "\xC3\xA9", "\xFF"
+   };
+
+   for(size_t N = 1 + rnd(4); N > 0; N--)
+   {
+      size_t pos = rnd(data.size() + 1);
+
+      switch(rnd(6))
+      {
+         case 0 : if(pos < data.size())
+                     data[pos] ^= 1 << rnd(8);
+                  break;
+
+         case 1 : data.insert(pos, 1, (char) rnd(256));
+                  break;
+
+         case 2 : data.insert(pos, tokens[rnd(sizeof tokens / sizeof *tokens)]);
+                  break;
+
+         case 3 : data.erase(pos, 1 + rnd(8));
+                  break;
+
+         case 4 : { size_t len = rnd(data.size() - pos + 1);
+                    data.insert(rnd(data.size() + 1), data.substr(pos, len)); }
+                  break;
+
+         case 5 : data.resize(pos);
+                  break;
+      }
+   }
+
+   if(data.size() > max_len)
+      data.resize(max_len);
+}
+
+int main(int argc, char **argv)
+{
+   long runs = 0;
+   size_t max_len = 4096;
+   vector<string> inputs;
+
+   for(int I = 1; I < argc; I++)
+   {
+      if(0 == strncmp(argv[I], "-runs=", 6))
+         runs = atol(argv[I] + 6);
+      else if(0 == strncmp(argv[I], "-seed=", 6))
+         rnd_state = strtoull(argv[I] + 6, NULL, 10) | 1;
+      else if(0 == strncmp(argv[I], "-max_len=", 9))
+         max_len = atol(argv[I] + 9);
+      else if(0 == strcmp(argv[I], "-detect_leaks=1"))
+         detect_leaks = true;
+      else if('-' != argv[I][0])
+         read_path(argv[I], inputs);
+   }
+
+   signal(SIGABRT, on_abort);
+#if defined(__SANITIZE_ADDRESS__)
+   __sanitizer_set_death_callback(save_current);
+#endif
+
+   size_t seeds = inputs.size();
+   for(size_t I = 0; I < seeds; I++)
+      run(inputs[I]);
+
+   if(inputs.empty())
+      inputs.push_back("{}");
+
+   for(long I = 0; I < runs; I++)
+   {
+      /* edits pile up now and then, so inputs drift from the seeds */
+      string data = inputs[rnd(inputs.size())];
+      mutate(data, max_len);
+      run(data);
+      if(0 == rnd(8) and inputs.size() < 10000)
+         inputs.push_back(data);
+   }
+
+   fprintf(stderr, "%zu inputs and %ld mutations ran\n", seeds, runs);
+   return 0;
+}
@@ -0,0 +1,58 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+
+#include "Icejson.h"
+
+/* checks shared by the unit tests, each test is one executable run
+ * by ctest; a failed CHECK reports itself and the test carries on,
+ * so a run lists every failure and main returns their number */
+static int failures;
+
+#define CHECK(cond)                                                     \
+   ((cond) ? (void) 0 : (void) (failures++,                             \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond)))
+
+/* text of a node as written with no padding */
+static inline std::string text(Icejson::Node_t &node)
+{
+   int len = node.write((char *) NULL, 0, NULL);
+   std::string out(len + 1, '\0');
+   node.write(&out[0], out.size(), NULL);
+   out.resize(len);
+   return out;
+}
+
+/* writes data to a new file in the temporary directory and returns
+ * its path, the caller unlinks it */
+static inline std::string temp_file(const std::string &data)
+{
+   const char *dir = getenv("TMPDIR");
+   std::string path = std::string(dir ? dir : "/tmp") + "/icejson_test_XXXXXX";
+   int fd = mkstemp(&path[0]);
+   if(fd < 0 or (ssize_t) data.size() != write(fd, data.data(), data.size()))
+      path.clear();
+   if(fd >= 0) close(fd);
+   return path;
+}
+
+static inline int report(const char *name)
+{
+   if(failures)
+      fprintf(stderr, "%s: %d checks failed\n", name, failures);
+   return failures ? 1 : 0;
+}
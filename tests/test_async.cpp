@@ -0,0 +1,139 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include <fcntl.h>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "test.h"
+
+using namespace Icejson;
+
+struct Wait_t
+{
+   std::mutex mtx;
+   std::condition_variable cv;
+   bool done = false;
+   bool ok = false;
+
+   static void finish(Doc_t &doc, void *arg)
+   {
+      Wait_t *wt = (Wait_t *) arg;
+      std::lock_guard<std::mutex> lck(wt->mtx);
+      wt->ok = doc.root().valid();
+      wt->done = true;
+      wt->cv.notify_all();
+   }
+
+   void wait()
+   {
+      std::unique_lock<std::mutex> lck(mtx);
+      cv.wait(lck, [this] { return done; });
+   }
+};
+
+static void load(const char *json, bool expect)
+{
+   std::string path = temp_file(json);
+   int fd = open(path.c_str(), O_RDONLY);
+
+   Doc_t doc;
+   Wait_t wt;
+   doc.parse_async(fd, &Wait_t::finish, &wt);
+   wt.wait();
+
+   CHECK(expect == wt.ok);
+   CHECK(expect == doc.error.desc.empty());
+   if(expect)
+      CHECK(2 == (int) doc.root()["b"][1]);
+
+   close(fd);
+   unlink(path.c_str());
+}
+
+/* after shutdown_async the pool is gone and comes back on next use */
+static void test_shutdown()
+{
+   std::string path = temp_file("{\"b\":[1,2]}");
+   int fd = open(path.c_str(), O_RDONLY);
+
+   Doc_t doc;
+   Wait_t wt;
+   doc.parse_async(fd, &Wait_t::finish, &wt);
+   shutdown_async();
+   CHECK(wt.done and wt.ok);
+
+   load("{\"a\":1,\"b\":[1,2]}", true);
+   shutdown_async();
+   shutdown_async();
+
+   close(fd);
+   unlink(path.c_str());
+}
+
+#ifdef __cpp_impl_coroutine
+/* a coroutine started at once and never suspended at its end, which
+ * records what co_await gave and on which thread it went on */
+struct Task_t
+{
+   struct promise_type
+   {
+      Task_t get_return_object() { return Task_t(); }
+      std::suspend_never initial_suspend() { return {}; }
+      std::suspend_never final_suspend() noexcept { return {}; }
+      void return_void() {}
+      void unhandled_exception() { abort(); }
+   };
+};
+
+static Task_t await_parse(Doc_t &doc, int fd, Wait_t &wt, std::thread::id &on)
+{
+   Node_t &root = co_await doc.parse_async(fd);
+   on = std::this_thread::get_id();
+   CHECK(not root or 2 == (int) root["b"][1]);
+   Wait_t::finish(doc, &wt);
+}
+
+/* the awaitable gives the root and the coroutine goes on on the pool
+ * thread, as documented */
+static void test_await(const char *json, bool expect)
+{
+   std::string path = temp_file(json);
+   int fd = open(path.c_str(), O_RDONLY);
+
+   Doc_t doc;
+   Wait_t wt;
+   std::thread::id on;
+   await_parse(doc, fd, wt, on);
+   wt.wait();
+
+   CHECK(expect == wt.ok);
+   CHECK(std::this_thread::get_id() != on);
+
+   close(fd);
+   unlink(path.c_str());
+}
+#endif
+
+int main()
+{
+   load("{\"a\":1,\"b\":[1,2]}", true);
+   load("{\"a\":1,\"b\":[1,2]", false);
+   test_shutdown();
+#ifdef __cpp_impl_coroutine
+   test_await("{\"a\":1,\"b\":[1,2]}", true);
+   test_await("{\"a\":", false);
+   return report("test_async_cxx20");
+#else
+   return report("test_async");
+#endif
+}
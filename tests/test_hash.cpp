@@ -0,0 +1,68 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include "test.h"
+
+using namespace Icejson;
+
+static uint64_t hash_of(const char *json, std::string *canon = NULL)
+{
+   Doc_t doc;
+   doc.pack_numbers = NULL != canon;
+   Node_t &root = doc.parse_string(json);
+   CHECK(root);
+   if(canon)
+   {
+      canon->clear();
+      root.write_canonical(*canon);
+   }
+   return root.hash();
+}
+
+static void test_hash()
+{
+   CHECK(hash_of("{\"a\":1,\"b\":[2,3]}") == hash_of("{\"b\":[2,3],\"a\":1.0}"));
+   CHECK(hash_of("{\"a\":1}") != hash_of("{\"a\":2}"));
+   CHECK(hash_of("{\"a\":[1,2]}") != hash_of("{\"a\":[2,1]}"));
+   CHECK(hash_of("{\"a\":\"1\"}") != hash_of("{\"a\":1}"));
+   CHECK(hash_of("{\"a\":{}}") != hash_of("{\"a\":[]}"));
+   CHECK(hash_of("{\"ab\":1}") != hash_of("{\"ba\":1}"));
+}
+
+static void test_canonical()
+{
+   std::string lhs, rhs;
+   hash_of("{ \"b\" : [1.0, 2.5], \"a\" : {\"y\":null, \"x\":\"\\u00e9\"} }", &lhs);
+   hash_of("{\"a\":{\"x\":\"\xc3\xa9\",\"y\":null},\"b\":[1,2.5]}", &rhs);
+   CHECK("{\"a\":{\"x\":\"\xc3\xa9\",\"y\":null},\"b\":[1,2.5]}" == lhs);
+   CHECK(lhs == rhs);
+}
+
+/* the cached hash follows edits made by apply_patch */
+static void test_cache()
+{
+   Doc_t doc;
+   Node_t &root = doc.parse_string("{\"a\":{\"b\":[1]}}");
+   uint64_t before = root.hash();
+   CHECK(before == root.hash());
+
+   CHECK(doc.apply_patch("[{\"op\":\"add\",\"path\":\"/a/b/-\",\"value\":2}]"));
+   CHECK(before != root.hash());
+   CHECK(root.hash() == hash_of("{\"a\":{\"b\":[1,2]}}"));
+}
+
+int main()
+{
+   test_hash();
+   test_canonical();
+   test_cache();
+   return report("test_hash");
+}
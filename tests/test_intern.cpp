@@ -0,0 +1,94 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include <string.h>
+#include <sstream>
+
+#include "test.h"
+
+using namespace Icejson;
+
+/* every member with the same name points to one symbol */
+static void test_own_table()
+{
+   Doc_t doc;
+   Node_t &root = doc.parse_string("{\"id\":1,\"sub\":{\"id\":2},\"n\\u0061me\":3}");
+   CHECK(root);
+
+   CHECK(root["id"].name.sym() == root["sub"]["id"].name.sym());
+   CHECK(root["id"].name == "id");
+   CHECK(3 == (int) root["name"]);
+   CHECK(not root["missing"]);
+   CHECK(doc.names().find("sub", 3));
+   CHECK(NULL == doc.names().find("missing", 7));
+}
+
+/* a shared table gives names the same id across documents */
+static void test_shared_table()
+{
+   Intern_t table;
+   Doc_t one, two;
+   one.intern = &table;
+   two.intern = &table;
+
+   Node_t &lhs = one.parse_string("{\"a\":1,\"b\":2}");
+   Node_t &rhs = two.parse_string("{\"b\":3}");
+   CHECK(lhs["b"].name.id() == rhs["b"].name.id());
+   CHECK(lhs["b"].name == rhs["b"].name);
+   CHECK(2 == table.size());
+
+   const Sym_t *sym = table.intern("b", 1);
+   CHECK(sym == lhs["b"].name.sym());
+   CHECK(3 == (int) rhs[sym]);
+}
+
+/* names still read as the strings they used to be */
+static void test_string_like()
+{
+   Doc_t doc;
+   Node_t &root = doc.parse_string("{\"id\":1}");
+   Name_t &name = root["id"].name;
+
+   CHECK(0 == strcmp("id", name.c_str()) and 2 == name.length());
+   CHECK('d' == name[1] and name != "ids" and not (name != "id"));
+   CHECK("id" == std::string(name));
+
+   std::ostringstream os;
+   os << name << root.name;
+   CHECK("id" == os.str());
+}
+
+/* the own table keeps its names when the document parses again */
+static void test_reuse()
+{
+   Doc_t doc;
+   const Sym_t *sym = doc.parse_string("{\"id\":1,\"x\":2}")["id"].name.sym();
+   CHECK(sym == doc.parse_string("{\"id\":3}")["id"].name.sym());
+   CHECK(2 == doc.names().size());
+
+   for(int I = 0; I <= Doc_t::KeepNames; I++)
+   {
+      char name[16];
+      snprintf(name, sizeof name, "n%d", I);
+      doc.names().intern(name, strlen(name));
+   }
+   CHECK(doc.parse_string("{\"id\":4}"));
+   CHECK(1 == doc.names().size() and 4 == (int) doc.root()["id"]);
+}
+
+int main()
+{
+   test_own_table();
+   test_string_like();
+   test_reuse();
+   test_shared_table();
+   return report("test_intern");
+}
@@ -0,0 +1,130 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include <math.h>
+#include <string>
+
+#include "test.h"
+
+using namespace Icejson;
+
+static void test_literals()
+{
+   Doc_t doc;
+   Node_t &root = doc.parse_string("\t{ \"t\" :true,\r\n\"f\": false , \"n\":null }\n");
+   CHECK(root);
+   CHECK(Valtype::Bool == root["t"].value_type());
+   CHECK(Valtype::Null == root["n"].value_type());
+
+   CHECK(not doc.parse_string("{\"t\":tru}"));
+   CHECK(not doc.parse_string("{\"t\":truex}"));
+   CHECK(not doc.parse_string("{\"n\":nul"));
+}
+
+static void test_numbers()
+{
+   Doc_t doc;
+   Node_t &root = doc.parse_string("{\"a\":-12,\"b\":0.1,\"c\":1e3,\"d\":-2.5E-1,"
+         "\"e\":9223372036854775807,\"f\":123456789012345678}");
+   CHECK(root);
+   CHECK(-12 == (long long) root["a"]);
+   CHECK(0.1 == (double) root["b"]);
+   CHECK(Valtype::Float == root["c"].value_type() and 1000 == (double) root["c"]);
+   CHECK(-0.25 == (double) root["d"]);
+   CHECK(9223372036854775807LL == (long long) root["e"]);
+   CHECK(123456789012345678LL == (long long) root["f"]);
+
+   CHECK(not doc.parse_string("{\"a\":-}"));
+   CHECK(not doc.parse_string("{\"a\":1.}"));
+   CHECK(not doc.parse_string("{\"a\":1e}"));
+}
+
+static void test_strings()
+{
+   Doc_t doc;
+   Node_t &root = doc.parse_string("{\"a\":\"x\\n\\t\\\"\\\\\\/\","
+         "\"u\":\"\\u0041\\u00e9\\u20ac\\ud83d\\ude00\",\"z\":\"a\\u0000b\"}");
+   CHECK(root);
+   CHECK("x\n\t\"\\/" == (std::string) root["a"]);
+   CHECK("A\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80" == (std::string) root["u"]);
+   CHECK(std::string("a\0b", 3) == (std::string) root["z"]);
+
+   /* long strings cross the decode buffer with escapes on its edge */
+   for(int len = 118; len < 132; len++)
+   {
+      std::string val(len, 'a');
+      std::string json = "{\"k\":\"" + val + "\\u00e9" + val + "\"}";
+      Node_t &node = doc.parse_string(json.c_str());
+      CHECK(val + "\xc3\xa9" + val == (std::string) node["k"]);
+   }
+
+   CHECK(not doc.parse_string("{\"a\":\"open"));
+   CHECK(not doc.parse_string("{\"a\":\"\\q\"}"));
+   CHECK(not doc.parse_string("{\"a\":\"\\u12g4\"}"));
+}
+
+static void test_errors()
+{
+   Doc_t doc;
+   CHECK(not doc.parse_string("{\n\"a\":1,\n\"b\":}"));
+   CHECK(3 == doc.error.line);
+   CHECK(not doc.error.desc.empty());
+
+   /* nesting is limited, deeper documents fail cleanly */
+   std::string deep = "{\"a\":" + std::string(2000, '[') + std::string(2000, ']') + "}";
+   CHECK(not doc.parse_string(deep.c_str()));
+   CHECK("Nesting too deep" == doc.error.desc);
+}
+
+/* values a projection steps over are checked as strictly as the
+ * ones it keeps */
+static void test_skipped()
+{
+   Projection_t proj;
+   CHECK(proj.add("k"));
+
+   Doc_t doc;
+   Node_t &root = doc.parse_string("{\"s\":\"\\\"\\\\\\/\\b\\f\\n\\r\\t\\u00aF\","
+         "\"n\":[-1.5e+3,0,12345678901234567890123],\"k\":1}", proj);
+   CHECK(root and 1 == (int) root["k"] and not root["s"]);
+
+   CHECK(not doc.parse_string("{\"s\":\"\\a\",\"k\":1}", proj));
+   CHECK(not doc.parse_string("{\"s\":\"\\u00g0\",\"k\":1}", proj));
+   CHECK(not doc.parse_string("{\"s\":\"\\", proj));
+   CHECK(not doc.parse_string("{\"n\":1e,\"k\":1}", proj));
+   CHECK(not doc.parse_string("{\"n\":-,\"k\":1}", proj));
+}
+
+static void test_nonfinite()
+{
+   Doc_t doc;
+   doc.options = ParseOptions::NanInfinity;
+   Node_t &root = doc.parse_string("{\"a\":NaN,\"b\":-Infinity,\"c\":[Infinity]}");
+   CHECK(root);
+   CHECK(root["a"] and (double) root["a"] != (double) root["a"]);
+   CHECK(-HUGE_VAL == (double) root["b"]);
+
+   /* the words are not read past the end of the text */
+   CHECK(not doc.parse_string("{\"a\":Na"));
+   CHECK(not doc.parse_string("{\"a\":-Infinit"));
+   CHECK(not doc.parse_string("{\"a\":NaNa}"));
+}
+
+int main()
+{
+   test_literals();
+   test_numbers();
+   test_strings();
+   test_errors();
+   test_skipped();
+   test_nonfinite();
+   return report("test_lexer");
+}
@@ -0,0 +1,52 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include "test.h"
+
+using namespace Icejson;
+
+static void test_roundtrip()
+{
+   const char *json = "{\"i\":-5,\"big\":9223372036854775807,\"f\":0.25,\"s\":\"h\\u00e9\","
+         "\"t\":true,\"n\":null,\"a\":[1,[],{}],\"o\":{\"k\":\"v\"}}";
+
+   Doc_t doc;
+   Node_t &root = doc.parse_string(json);
+   CHECK(root);
+
+   std::string pack;
+   CHECK(0 < root.write_msgpack(pack));
+   CHECK(0x88 == (unsigned char) pack[0]);   /* fixmap of 8 */
+
+   Doc_t back;
+   Node_t &copy = back.parse_msgpack(pack.data(), pack.size());
+   CHECK(copy);
+   CHECK(text(root) == text(copy));
+   CHECK(9223372036854775807LL == (long long) copy["big"]);
+}
+
+static void test_malformed()
+{
+   Doc_t doc;
+   const char trunc[] = "\x81\xa1" "k";   /* value missing */
+   CHECK(not doc.parse_msgpack(trunc, sizeof trunc - 1));
+   CHECK(not doc.error.desc.empty());
+
+   const char array[] = "\x90";   /* root has to be a map */
+   CHECK(not doc.parse_msgpack(array, 1));
+}
+
+int main()
+{
+   test_roundtrip();
+   test_malformed();
+   return report("test_msgpack");
+}
@@ -0,0 +1,83 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include <math.h>
+
+#include "test.h"
+
+using namespace Icejson;
+
+static bool parses(int options, const char *json)
+{
+   Doc_t doc;
+   doc.options = options;
+   return doc.parse_string(json).valid();
+}
+
+static void test_strict()
+{
+   CHECK(parses(ParseOptions::Strict, "{\"a\":[1,2]}"));
+   CHECK(not parses(ParseOptions::Strict, "{\"a\":[1,2,]}"));
+   CHECK(not parses(ParseOptions::Strict, "{\"a\":1 // c\n}"));
+   CHECK(not parses(ParseOptions::Strict, "[1]"));
+   CHECK(not parses(ParseOptions::Strict, "{\"a\":NaN}"));
+   CHECK(not parses(ParseOptions::Strict, "{} x"));
+}
+
+static void test_lenient()
+{
+   CHECK(parses(ParseOptions::TrailingCommas, "{\"a\":[1,2,],}"));
+   CHECK(not parses(ParseOptions::TrailingCommas, "{\"a\":[1,,]}"));
+   CHECK(parses(ParseOptions::Comments, "/* c */{\"a\" // c\n:1 /**/}// end"));
+   CHECK(not parses(ParseOptions::Comments, "{\"a\":1 /* open"));
+   CHECK(parses(ParseOptions::AnyRoot, "[1,2]"));
+   CHECK(parses(ParseOptions::AnyRoot, "\"text\""));
+
+   Doc_t doc;
+   doc.options = ParseOptions::NanInfinity;
+   Node_t &root = doc.parse_string("{\"a\":NaN,\"b\":-Infinity}");
+   CHECK(root and isnan((double) root["a"]));
+   CHECK(isinf((double) root["b"]) and (double) root["b"] < 0);
+   CHECK("{\"a\":NaN,\"b\":-Infinity}" == text(root));
+}
+
+static void test_duplicates()
+{
+   Doc_t doc;
+   const char *json = "{\"a\":1,\"b\":0,\"a\":2}";
+
+   CHECK(3 == doc.parse_string(json).count());
+
+   doc.options = ParseOptions::DupFirst;
+   CHECK(1 == (int) doc.parse_string(json)["a"] and 2 == doc.root().count());
+
+   doc.options = ParseOptions::DupLast;
+   CHECK(2 == (int) doc.parse_string(json)["a"] and 2 == doc.root().count());
+
+   doc.options = ParseOptions::DupError;
+   CHECK(not doc.parse_string(json));
+
+   /* one field, the other options leave the policy as it is */
+   CHECK(ParseOptions::DupFirst != ParseOptions::DupLast and
+         ParseOptions::DupLast != ParseOptions::DupError);
+   doc.options = ParseOptions::DupFirst | ParseOptions::TrailingCommas;
+   CHECK(ParseOptions::DupFirst == (doc.options & ParseOptions::DupPolicy));
+   CHECK(1 == (int) doc.parse_string("{\"a\":1,\"a\":2,}")["a"]);
+   CHECK(1 == doc.root().count());
+}
+
+int main()
+{
+   test_strict();
+   test_lenient();
+   test_duplicates();
+   return report("test_options");
+}
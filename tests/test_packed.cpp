@@ -0,0 +1,116 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include <vector>
+
+#include "test.h"
+
+using namespace Icejson;
+
+static void test_packed()
+{
+   Doc_t doc;
+   doc.pack_numbers = true;
+   Node_t &root = doc.parse_string("{\"i\":[1,2,3],\"f\":[1.5,-2.0],\"m\":[1,\"x\"],\"e\":[]}");
+   CHECK(root);
+
+   Node_t &ints = root["i"];
+   CHECK(Valtype::Packed == ints.value_type());
+   CHECK(Valtype::Int == ints.packed_type() and 3 == ints.count());
+   CHECK(3 == ints.packed_ints()[2]);
+
+   Node_t &floats = root["f"];
+   CHECK(Valtype::Float == floats.packed_type());
+   CHECK(-2 == floats.packed_floats()[1]);
+
+   CHECK(Valtype::Array == root["m"].value_type());
+
+   std::vector<double> vec;
+   CHECK(3 == ints.extract(vec) and 3.0 == vec[2]);
+   CHECK(-1 == root["m"].extract(vec));
+
+   doc.writer.float_format = "%g";
+   CHECK("{\"i\":[1,2,3],\"f\":[1.5,-2],\"m\":[1,\"x\"],\"e\":[]}" == text(root));
+}
+
+/* ints keep their type, so an array mixing them with floats and one
+ * with an int past long long stay plain */
+static void test_mixed()
+{
+   Doc_t doc;
+   doc.pack_numbers = true;
+   Node_t &root = doc.parse_string("{\"m\":[1,2.5],\"w\":[1,99999999999999999999]}");
+   CHECK(root);
+
+   CHECK(Valtype::Array == root["m"].value_type());
+   CHECK(Valtype::Int == root["m"][0].value_type());
+   CHECK("{\"m\":[1,2.500000],\"w\":[1,100000000000000000000.000000]}" == text(root));
+
+   Node_t &wide = root["w"][1];
+   CHECK(Valtype::Float == wide.value_type() and 1e20 == (double) wide);
+}
+
+/* the node interface walks packed arrays as it does plain ones */
+static void test_access()
+{
+   Doc_t doc;
+   doc.pack_numbers = true;
+   Node_t &root = doc.parse_string("{\"i\":[4,5,6],\"f\":[0.5]}");
+   Node_t &ints = root["i"];
+
+   CHECK(Valtype::Packed == ints.value_type());
+   CHECK(5 == (long long) ints[1] and Valtype::Int == ints[1].value_type());
+   CHECK(not ints[3] and not ints[-1]);
+   CHECK(&ints == &ints[2].parent());
+   CHECK(6 == (int) *ints.back() and 4 == (int) *ints.front());
+
+   long long sum = 0;
+   int count = 0;
+   for(Iterator_t itr = ints.front(); itr; ++itr, count++)
+      sum += (long long) *itr;
+   CHECK(3 == count and 15 == sum);
+
+   CHECK(0.5 == (double) root["f"][0]);
+   CHECK(Valtype::Packed == ints.value_type() and 6 == ints.packed_ints()[2]);
+}
+
+/* extract gives the same numbers for plain arrays */
+static void test_plain()
+{
+   Doc_t doc;
+   Node_t &root = doc.parse_string("{\"a\":[1,2.5,3]}");
+   std::vector<long long> vec;
+   CHECK(3 == root["a"].extract(vec) and 2 == vec[1]);
+}
+
+/* a short buffer gets what fits and the result gives the whole count */
+static void test_short()
+{
+   Doc_t doc;
+   doc.pack_numbers = true;
+   Node_t &root = doc.parse_string("{\"p\":[1,2,3],\"a\":[1,2.5,\"x\"],\"b\":[1,2.5,3]}");
+
+   long long buf[2] = { 0, 0 };
+   CHECK(3 == root["p"].extract(buf, 2) and 2 == buf[1]);
+   CHECK(3 == root["b"].extract(buf, 2) and 2 == buf[1]);
+   CHECK(-1 == root["a"].extract(buf, 2));
+   CHECK(3 == root["p"].extract(buf, 0));
+}
+
+int main()
+{
+   test_packed();
+   test_mixed();
+   test_access();
+   test_plain();
+   test_short();
+   return report("test_packed");
+}
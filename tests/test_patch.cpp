@@ -0,0 +1,133 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include "test.h"
+
+using namespace Icejson;
+
+static std::string canonical(Node_t &node)
+{
+   std::string out;
+   node.write_canonical(out);
+   return out;
+}
+
+/* the patch from diff turns a copy of from into to; member order does
+ * not count, and diffing the result against to has to find nothing */
+static void roundtrip(const char *from, const char *to, int expect)
+{
+   Doc_t lhs, rhs, copy;
+   Node_t &src = lhs.parse_string(from);
+   Node_t &dst = rhs.parse_string(to);
+   CHECK(src and dst and copy.parse_string(from));
+
+   std::string patch, rest;
+   CHECK(expect == src.diff(dst, patch));
+   CHECK(copy.apply_patch(patch.c_str()));
+   if(canonical(copy.root()) != canonical(dst) or 0 != copy.root().diff(dst, rest))
+   {
+      fprintf(stderr, "%s -> %s\n   patch %s\n   gives %s\n", from, to,
+            patch.c_str(), text(copy.root()).c_str());
+      CHECK(not "patch applies");
+   }
+}
+
+static void test_diff()
+{
+   roundtrip("{\"a\":1}", "{\"a\":1}", 0);
+   roundtrip("{\"a\":1,\"b\":2}", "{\"b\":3,\"c\":[1]}", 3);
+   roundtrip("{\"a\":[1,2,3,4]}", "{\"a\":[1,5,3,4,6]}", 2);
+   roundtrip("{\"a\":[1,2,3]}", "{\"a\":[2,3]}", 1);
+   roundtrip("{\"a\":{\"b\":{\"c\":1}}}", "{\"a\":{\"b\":{\"c\":\"1\"}}}", 1);
+   roundtrip("{\"a/b\":1,\"c~d\":2}", "{\"a/b\":2}", 2);
+   roundtrip("{\"a\":1}", "{\"a\":1.0}", 0);
+   roundtrip("{\"a\":1}", "{\"a\":1.5}", 1);
+   roundtrip("{\"a\":[]}", "{\"a\":{}}", 1);
+   roundtrip("{\"a\":1,\"b\":2}", "{\"b\":2,\"a\":1}", 0);
+   roundtrip("{\"a\":1,\"a\":1}", "{\"a\":1,\"b\":1}", 2);
+
+   /* these names share a 32 bit hash, the rename must not be lost */
+   roundtrip("{\"k8482\":1}", "{\"k74682\":1}", 2);
+   roundtrip("{\"o\":[{\"k8482\":1}]}", "{\"o\":[{\"k74682\":1}]}", 2);
+}
+
+static void test_apply()
+{
+   Doc_t doc;
+   CHECK(doc.parse_string("{\"a\":[1,2],\"b\":{\"c\":3}}"));
+
+   CHECK(doc.apply_patch("[{\"op\":\"add\",\"path\":\"/a/-\",\"value\":9},"
+            "{\"op\":\"copy\",\"from\":\"/b\",\"path\":\"/d\"},"
+            "{\"op\":\"move\",\"from\":\"/b/c\",\"path\":\"/e\"},"
+            "{\"op\":\"test\",\"path\":\"/a/2\",\"value\":9},"
+            "{\"op\":\"replace\",\"path\":\"/a/0\",\"value\":\"x\"}]"));
+   CHECK("{\"a\":[\"x\",2,9],\"b\":{},\"d\":{\"c\":3},\"e\":3}" == text(doc.root()));
+
+   /* ops before the failing one stay applied */
+   CHECK(not doc.apply_patch("[{\"op\":\"remove\",\"path\":\"/e\"},"
+            "{\"op\":\"test\",\"path\":\"/a/1\",\"value\":3}]"));
+   CHECK(2 == doc.error.offset);
+   CHECK(not doc.root()["e"]);
+
+   CHECK(not doc.apply_patch("[{\"op\":\"remove\",\"path\":\"/nope\"}]"));
+   CHECK(not doc.apply_patch("[{\"op\":\"jump\",\"path\":\"/a\"}]"));
+}
+
+/* a move to a path that does not resolve leaves the source in place */
+static void test_move_failure()
+{
+   Doc_t doc;
+   CHECK(doc.parse_string("{\"a\":[1,2,3],\"b\":{}}"));
+
+   CHECK(not doc.apply_patch("[{\"op\":\"move\",\"from\":\"/a/0\",\"path\":\"/b/zz/q\"}]"));
+   CHECK("{\"a\":[1,2,3],\"b\":{}}" == text(doc.root()));
+   CHECK(not doc.apply_patch("[{\"op\":\"move\",\"from\":\"/a/2\",\"path\":\"/a/9\"}]"));
+   CHECK(not doc.apply_patch("[{\"op\":\"move\",\"from\":\"/b\",\"path\":\"/a/x\"}]"));
+   CHECK("{\"a\":[1,2,3],\"b\":{}}" == text(doc.root()));
+
+   CHECK(doc.apply_patch("[{\"op\":\"move\",\"from\":\"/a/0\",\"path\":\"/a/2\"}]"));
+   CHECK("{\"a\":[2,3,1],\"b\":{}}" == text(doc.root()));
+}
+
+/* test compares numbers by value, and it and the source of a copy
+ * read packed arrays without unpacking them */
+static void test_numbers()
+{
+   Doc_t doc;
+   doc.pack_numbers = true;
+   CHECK(doc.parse_string("{\"a\":1,\"p\":[1,2,3],\"f\":[0.5,2.0]}"));
+
+   CHECK(doc.apply_patch("[{\"op\":\"test\",\"path\":\"/a\",\"value\":1.0},"
+            "{\"op\":\"test\",\"path\":\"/p/1\",\"value\":2},"
+            "{\"op\":\"test\",\"path\":\"/f/1\",\"value\":2},"
+            "{\"op\":\"test\",\"path\":\"/p\",\"value\":[1.0,2,3]},"
+            "{\"op\":\"copy\",\"from\":\"/p/2\",\"path\":\"/c\"}]"));
+   CHECK(not doc.apply_patch("[{\"op\":\"test\",\"path\":\"/f/0\",\"value\":0}]"));
+   CHECK(not doc.apply_patch("[{\"op\":\"test\",\"path\":\"/p/0/x\",\"value\":0}]"));
+   CHECK(Valtype::Packed == doc.root()["p"].value_type());
+   CHECK(Valtype::Packed == doc.root()["f"].value_type());
+   CHECK(3 == (int) doc.root()["c"]);
+
+   CHECK(doc.apply_patch("[{\"op\":\"test\",\"path\":\"/p/0\",\"value\":1},"
+            "{\"op\":\"replace\",\"path\":\"/p/0\",\"value\":7},"
+            "{\"op\":\"test\",\"path\":\"/p/0\",\"value\":7}]"));
+   CHECK(Valtype::Array == doc.root()["p"].value_type());
+   CHECK("\"p\":[7,2,3]" == text(doc.root()["p"]));
+}
+
+int main()
+{
+   test_diff();
+   test_apply();
+   test_move_failure();
+   test_numbers();
+   return report("test_patch");
+}
@@ -0,0 +1,65 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include "test.h"
+
+using namespace Icejson;
+
+static const char *json = "{\"user\":{\"id\":7,\"name\":\"x\",\"tags\":[1,2]},"
+      "\"items\":[{\"price\":1.5,\"qty\":2},{\"qty\":1},{\"price\":3}],"
+      "\"skip\":[{\"deep\":[[[\"\\u00e9\"]]]}],\"last\":true}";
+
+static void test_paths()
+{
+   Projection_t proj;
+   CHECK(proj.add("user.id"));
+   CHECK(proj.add("items[*].price"));
+   CHECK(proj.add("user.tags"));
+   CHECK(proj.add("last"));
+
+   Doc_t doc;
+   Node_t &root = doc.parse_string(json, proj);
+   CHECK(root);
+   CHECK("{\"user\":{\"id\":7,\"tags\":[1,2]},\"items\":[{\"price\":1.500000},{},"
+         "{\"price\":3}],\"last\":true}" == text(root));
+}
+
+static void test_index()
+{
+   Projection_t proj;
+   CHECK(proj.add("items[1]"));
+
+   Doc_t doc;
+   Node_t &root = doc.parse_string(json, proj);
+   CHECK("{\"items\":[{\"qty\":1}]}" == text(root));
+}
+
+static void test_malformed()
+{
+   Projection_t proj;
+   CHECK(not proj.add(""));
+   CHECK(not proj.add("a..b"));
+   CHECK(not proj.add("a[x]"));
+   CHECK(proj.add("user.id"));
+
+   /* skipped parts are still checked */
+   Doc_t doc;
+   CHECK(not doc.parse_string("{\"user\":{\"id\":1},\"other\":[1,}", proj));
+   CHECK(not doc.error.desc.empty());
+}
+
+int main()
+{
+   test_paths();
+   test_index();
+   test_malformed();
+   return report("test_projection");
+}
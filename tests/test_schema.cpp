@@ -0,0 +1,130 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include <math.h>
+#include <vector>
+
+#include "test.h"
+
+struct Point_t
+{
+   int x;
+   double y;
+   std::string label;
+   std::vector<int> tags;
+};
+
+ICEJSON_SCHEMA(Point_t, ICEJSON_FIELD(x) ICEJSON_FIELD(y)
+      ICEJSON_FIELD(label) ICEJSON_FIELD(tags))
+
+struct Tree_t
+{
+   float w;
+   std::vector<Tree_t> kids;
+};
+
+ICEJSON_SCHEMA(Tree_t, ICEJSON_FIELD(w) ICEJSON_FIELD(kids))
+
+using namespace Icejson;
+
+static void test_struct()
+{
+   Point_t pt = { 7, 0, "", {} };
+   Error_t err;
+
+   CHECK(parse_struct("{\"y\":2.5,\"skip\":{\"a\":[1,{}]},\"label\":\"a\\\"b\","
+            "\"tags\":[1,2,3],\"z\":null}", pt, err));
+   CHECK(7 == pt.x);   /* missing members keep their value */
+   CHECK(2.5 == pt.y);
+   CHECK("a\"b" == pt.label);
+   CHECK(3 == pt.tags.size() and 3 == pt.tags[2]);
+
+   std::string out;
+   write_struct(pt, out);
+   CHECK("{\"x\":7,\"y\":2.5,\"label\":\"a\\\"b\",\"tags\":[1,2,3]}" == out);
+
+   Point_t back = {};
+   CHECK(parse_struct(out.c_str(), back, err));
+   CHECK(7 == back.x and 2.5 == back.y and pt.label == back.label);
+
+   CHECK(not parse_struct("{\"x\":\"seven\"}", pt, err));
+   CHECK(not err.desc.empty());
+   CHECK(not parse_struct("{\"x\":1} x", pt, err));
+}
+
+static void test_arrays()
+{
+   Error_t err;
+   std::vector<double> vec;
+   CHECK(parse_array("[1, 2.5, -3e2]", vec, err));
+   CHECK(3 == vec.size() and -300 == vec[2]);
+
+   long long buf[2];
+   size_t count = 2;
+   CHECK(parse_array("[4,5]", buf, count, err) and 2 == count and 5 == buf[1]);
+
+   count = 2;
+   CHECK(not parse_array("[4,5,6]", buf, count, err) and 0 == count);
+}
+
+/* values a member can not hold fail rather than being cut */
+static void test_range()
+{
+   Point_t pt = { 0, 0, "", {} };
+   Error_t err;
+
+   CHECK(parse_struct("{\"x\":2147483647}", pt, err) and 2147483647 == pt.x);
+   CHECK(parse_struct("{\"x\":-2147483648}", pt, err) and -2147483647 - 1 == pt.x);
+   CHECK(not parse_struct("{\"x\":2147483648}", pt, err));
+   CHECK(not parse_struct("{\"tags\":[1,-4294967296]}", pt, err));
+
+   Tree_t tree = { 0, {} };
+   CHECK(not parse_struct("{\"w\":1e39}", tree, err));
+   CHECK(parse_struct("{\"w\":1e38}", tree, err));
+}
+
+/* JSON has no text for them, so they go out as null */
+static void test_nonfinite()
+{
+   Point_t pt = { 1, HUGE_VAL, "", {} };
+   std::string out;
+   write_struct(pt, out);
+   CHECK("{\"x\":1,\"y\":null,\"label\":\"\",\"tags\":[]}" == out);
+
+   Point_t back = { 0, 2, "", {} };
+   Error_t err;
+   CHECK(parse_struct(out.c_str(), back, err) and 2 == back.y);
+}
+
+/* a schema holding itself is held to the depth limit of the parser */
+static void test_depth()
+{
+   Error_t err;
+   Tree_t tree = { 0, {} };
+   CHECK(parse_struct("{\"w\":1,\"kids\":[{\"w\":2,\"kids\":[{}]},{}]}", tree, err));
+   CHECK(2 == tree.kids.size() and 1 == tree.kids[0].kids.size());
+
+   std::string deep;
+   for(int I = 0; I < 5000; I++)
+      deep += "{\"kids\":[";
+   CHECK(not parse_struct(deep.c_str(), tree, err));
+   CHECK("Nesting too deep" == err.desc);
+}
+
+int main()
+{
+   test_struct();
+   test_arrays();
+   test_range();
+   test_nonfinite();
+   test_depth();
+   return report("test_schema");
+}
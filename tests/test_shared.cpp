@@ -0,0 +1,100 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include <stdio.h>
+#include <vector>
+
+#include "test.h"
+
+using namespace Icejson;
+
+static void rewrite(const std::string &path, const char *json)
+{
+   FILE *fh = fopen(path.c_str(), "w");
+   fputs(json, fh);
+   fclose(fh);
+}
+
+/* a pinned version survives reloads and is freed once unpinned */
+static void test_swap()
+{
+   std::string path = temp_file("{\"v\":1}");
+   SharedDoc_t shared;
+
+   CHECK(not shared.pin());
+   CHECK(shared.load(path.c_str()));
+
+   {
+      SharedDoc_t::Guard_t old = shared.pin();
+      CHECK(old and 1 == (int) old.root()["v"]);
+
+      rewrite(path, "{\"v\":2}");
+      CHECK(shared.reload());
+
+      SharedDoc_t::Guard_t cur = shared.pin();
+      CHECK(2 == (int) cur.root()["v"]);
+      CHECK(1 == (int) old.root()["v"]);
+   }
+   shared.reclaim();
+
+   /* a failed reload keeps the current version */
+   rewrite(path, "{\"v\":");
+   CHECK(not shared.reload());
+   CHECK(not shared.error().desc.empty());
+   CHECK(2 == (int) shared.pin().root()["v"]);
+
+   /* and so does a missing file, with the error parse_file gave */
+   unlink(path.c_str());
+   CHECK(not shared.reload());
+   CHECK("Unable to open file" == shared.error().desc);
+   CHECK(2 == (int) shared.pin().root()["v"]);
+}
+
+static void test_nested_pins()
+{
+   std::string path = temp_file("{\"v\":1}");
+   SharedDoc_t shared;
+   CHECK(shared.load(path.c_str()));
+
+   SharedDoc_t::Guard_t outer = shared.pin();
+   SharedDoc_t::Guard_t inner = shared.pin();
+   CHECK(&outer.doc() == &inner.doc());
+
+   unlink(path.c_str());
+}
+
+/* once every reader slot is held pin fails instead of spinning */
+static void test_full()
+{
+   std::string path = temp_file("{\"v\":1}");
+   SharedDoc_t shared;
+   CHECK(shared.load(path.c_str()));
+
+   std::vector<SharedDoc_t::Guard_t> held;
+   held.reserve(SharedDoc_t::MaxReaders);
+   for(int I = 0; I < SharedDoc_t::MaxReaders; I++)
+      held.push_back(shared.pin());
+   CHECK(held.back());
+
+   CHECK(not shared.pin());
+   held.pop_back();
+   CHECK(shared.pin());
+
+   unlink(path.c_str());
+}
+
+int main()
+{
+   test_swap();
+   test_nested_pins();
+   test_full();
+   return report("test_shared");
+}
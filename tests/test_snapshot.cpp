@@ -0,0 +1,140 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include "test.h"
+
+using namespace Icejson;
+
+static const char *json = "{\"name\":\"ice\\njson\",\"n\":42,\"nums\":[1,2,3],"
+      "\"deep\":{\"a\":{\"b\":\"c\"}},\"arr\":[1,\"two\",{}]}";
+
+/* the second mapping in one process can not get the preferred address
+ * and is relocated, both have to read the same */
+static void test_open()
+{
+   std::string path = temp_file("");
+   std::string want;
+   {
+      Doc_t doc;
+      doc.pack_numbers = true;
+      Node_t &root = doc.parse_string(json);
+      want = text(root);
+      CHECK(doc.save_snapshot(path.c_str()));
+   }
+
+   Doc_t one, two;
+   Node_t &lhs = one.open_snapshot(path.c_str());
+   Node_t &rhs = two.open_snapshot(path.c_str());
+   CHECK(lhs and rhs and &lhs != &rhs);
+   CHECK(want == text(lhs) and want == text(rhs));
+
+   CHECK("ice\njson" == (std::string) rhs["name"]);
+   CHECK(3 == rhs["nums"].packed_ints()[2]);
+   CHECK(&rhs["deep"]["a"].doc() == &two);
+   CHECK(&rhs["deep"]["a"].parent().parent() == &rhs);
+   CHECK("c" == (std::string) rhs["deep"]["a"]["b"]);
+
+   /* snapshots are read-only */
+   CHECK(not two.apply_patch("[{\"op\":\"remove\",\"path\":\"/n\"}]"));
+
+   /* a re-parse replaces the mapped tree */
+   CHECK(one.parse_string("{\"x\":1}"));
+   CHECK(1 == (int) one.root()["x"]);
+
+   unlink(path.c_str());
+}
+
+static void test_bad_image()
+{
+   std::string path = temp_file("not an image at all, just text");
+   Doc_t doc;
+   CHECK(not doc.open_snapshot(path.c_str()));
+   CHECK(not doc.error.desc.empty());
+   CHECK(not doc.open_snapshot("/nonexistent/icejson.img"));
+   unlink(path.c_str());
+}
+
+static std::string read_file(const std::string &path)
+{
+   std::string data;
+   FILE *fh = fopen(path.c_str(), "rb");
+   if(NULL == fh) return data;
+   char buf[4096];
+   for(size_t len; (len = fread(buf, 1, sizeof buf, fh)) > 0; )
+      data.append(buf, len);
+   fclose(fh);
+   return data;
+}
+
+/* every word of the image is overwritten in turn with a stray value
+ * and with a pointer moved by a node; whatever still opens has to read
+ * without leaving the mapping, which the sanitizer build catches */
+static void test_corrupt()
+{
+   std::string path = temp_file("");
+   {
+      Doc_t doc;
+      doc.pack_numbers = true;
+      doc.parse_string(json);
+      CHECK(doc.save_snapshot(path.c_str()));
+   }
+   std::string image = read_file(path);
+   CHECK(image.size() > 0);
+
+   std::string half = temp_file(image.substr(0, image.size() / 2));
+   Doc_t doc;
+   CHECK(not doc.open_snapshot(half.c_str()));
+   CHECK(not doc.error.desc.empty());
+   unlink(half.c_str());
+
+   const uint64_t stray[] = { 0x4141414141414141ULL, sizeof(Node_t),
+         (uint64_t) -sizeof(Node_t), 1 };
+   /* the second pass has the image's range taken and relocates */
+   Doc_t holder;
+   int rejected = 0, opened = 0;
+   for(int pass = 0; pass < 2; pass++)
+   {
+      if(pass) CHECK(holder.open_snapshot(path.c_str()));
+
+      for(size_t off = 0; off + 8 <= image.size(); off += 8)
+      {
+         for(int K = 0; K < 4; K++)
+         {
+            std::string bad = image;
+            uint64_t word;
+            memcpy(&word, &bad[off], 8);
+            word = K ? word + stray[K] : stray[K];
+            memcpy(&bad[off], &word, 8);
+
+            std::string file = temp_file(bad);
+            Node_t &root = doc.open_snapshot(file.c_str());
+            if(root)
+            {
+               text(root);
+               root.hash();
+               opened++;
+            }
+            else rejected++;
+            unlink(file.c_str());
+         }
+      }
+   }
+   CHECK(rejected > 0 and opened > 0);
+   unlink(path.c_str());
+}
+
+int main()
+{
+   test_open();
+   test_bad_image();
+   test_corrupt();
+   return report("test_snapshot");
+}
@@ -0,0 +1,65 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include <string.h>
+
+#include "test.h"
+
+using namespace Icejson;
+
+static void test_counts()
+{
+   Doc_t doc;
+   doc.stats.enabled = true;
+   const char *json = "{\"a\":[1,2.5,\"s\\n\",true,null],\"o\":{\"b\":{}}}";
+   Node_t &root = doc.parse_string(json);
+   CHECK(root);
+
+#ifdef ICEJSON_STATS
+   CHECK((long long) strlen(json) == doc.stats.bytes);
+   CHECK(1 == doc.stats.ints and 1 == doc.stats.floats);
+   CHECK(1 == doc.stats.strings and 1 == doc.stats.bools and 1 == doc.stats.nulls);
+   CHECK(1 == doc.stats.arrays and 3 == doc.stats.objects);
+   CHECK(1 == doc.stats.escapes and 1 == doc.stats.strings_copied);
+   CHECK(3 == doc.stats.max_depth);
+   CHECK(29 == doc.stats.tokens);
+   CHECK(0 < doc.stats.parse_ns and 0 < doc.stats.lex_ns);
+
+   Doc_t out;
+   Node_t &exp = doc.stats.export_doc(out);
+   CHECK(1 == (long long) exp["nodes"]["int"]);
+   CHECK(29 == (long long) exp["tokens"]);
+   CHECK(doc.stats.lex_ns == (long long) exp["time_ns"]["lex"]);
+   CHECK(0 <= (long long) exp["time_ns"]["build"]);
+
+   /* names and skipped strings are not copies, skipped escapes are
+    * not decoded and the lexer pass counts nothing twice */
+   Projection_t proj;
+   CHECK(proj.add("k"));
+   doc.stats.reset();
+   CHECK(doc.parse_string("{\"k\":\"v\",\"x\":[\"a\\tb\",\"c\"]}", proj));
+   CHECK(1 == doc.stats.strings_copied and 0 == doc.stats.escapes);
+   CHECK(19 == doc.stats.tokens);
+#else
+   /* compiled out, the counters stay zero */
+   CHECK(0 == doc.stats.bytes and 0 == doc.stats.ints);
+   CHECK(0 == doc.stats.tokens and 0 == doc.stats.parse_ns);
+#endif
+
+   doc.stats.reset();
+   CHECK(0 == doc.stats.bytes);
+}
+
+int main()
+{
+   test_counts();
+   return report("test_stats");
+}
@@ -0,0 +1,88 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include <string.h>
+
+#include "test.h"
+
+using namespace Icejson;
+
+static bool valid(const char *json)
+{
+   Doc_t doc;
+   return doc.validate(json, strlen(json));
+}
+
+static void test_accepts()
+{
+   CHECK(valid("{}"));
+   CHECK(valid(" {\"a\":[1,-0.5e+3,true,false,null,\"\\u00e9\\ud83d\\ude00\",{}]} "));
+   CHECK(valid("{\"s\":\"caf\xc3\xa9\"}"));
+}
+
+static void test_rejects()
+{
+   CHECK(not valid(""));
+   CHECK(not valid("[1]"));              /* root has to be an object */
+   CHECK(not valid("{\"a\":01}"));
+   CHECK(not valid("{\"a\":1.}"));
+   CHECK(not valid("{\"a\":[1,]}"));
+   CHECK(not valid("{\"a\":\"\x01\"}"));
+   CHECK(not valid("{\"a\":\"\xc3\"}"));   /* cut UTF-8 sequence */
+   CHECK(not valid("{\"a\":\"\\x\"}"));
+   CHECK(not valid("{} {}"));
+
+   /* len bounds the read, NULs included */
+   Doc_t doc;
+   CHECK(not doc.validate("{\"a\":1}", 5));
+   CHECK(not doc.validate("{}\0", 3));
+   CHECK(not doc.error.desc.empty());
+}
+
+/* validate is strict whatever the options of the document */
+static void test_options()
+{
+   Doc_t doc;
+   doc.options = ParseOptions::TrailingCommas | ParseOptions::Comments;
+   const char *json = "{\"a\":[1,], /* c */ \"b\":2}";
+   CHECK(doc.parse_string(json));
+   CHECK(not doc.validate(json, strlen(json)));
+
+   Error_t err;
+   CHECK(not validate("{\"a\":}", 6, err));
+   CHECK(6 == err.offset and not err.desc.empty());
+}
+
+/* lone surrogates are kept as bytes that are not UTF-8 and come back
+ * out as escapes, so what write gives validates */
+static void test_surrogates()
+{
+   Doc_t doc;
+   Node_t &root = doc.parse_string("{\"s\":\"a\\uD800b\\udc01\",\"p\":\"\\ud83d\\ude00\"}");
+   CHECK(root);
+
+   std::string out = text(root);
+   CHECK("{\"s\":\"a\\ud800b\\udc01\",\"p\":\"\xf0\x9f\x98\x80\"}" == out);
+   CHECK(valid(out.c_str()));
+
+   Doc_t again;
+   CHECK(again.parse_string(out.c_str()));
+   CHECK((std::string) root["s"] == (std::string) again.root()["s"]);
+}
+
+int main()
+{
+   test_accepts();
+   test_rejects();
+   test_options();
+   test_surrogates();
+   return report("test_validate");
+}
@@ -0,0 +1,100 @@
+
+/**
+ *
+ * Author  : D.Dinesh
+ *           www.techybook.com
+ *           dinesh@techybook.com
+ *
+ * Licence : Refer the license file
+ *
+ **/
+
+#include <string.h>
+#include <sstream>
+
+#include "test.h"
+
+using namespace Icejson;
+
+static const char *json = "{\"a\\\"b\":\"line\\nbreak\",\"n\":[1,2.5,null,true],\"o\":{}}";
+
+static void test_sinks()
+{
+   Doc_t doc;
+   Node_t &root = doc.parse_string(json);
+   CHECK(root);
+
+   std::string compact = text(root);
+   CHECK("{\"a\\\"b\":\"line\\nbreak\",\"n\":[1,2.500000,null,true],\"o\":{}}" == compact);
+
+   /* every sink writes the same text and counts it */
+   char buf[256];
+   int len = root.write(buf, "   ");
+   CHECK(len == (int) strlen(buf));
+
+   std::ostringstream os;
+   CHECK(len == root.write(os, "   "));
+   CHECK(os.str() == buf);
+
+   Doc_t again;
+   CHECK(again.parse_string(buf) and compact == text(again.root()));
+}
+
+static void test_bounded()
+{
+   Doc_t doc;
+   Node_t &root = doc.parse_string(json);
+   int need = root.write((char *) NULL, 0, NULL);
+
+   for(int size = 1; size <= need + 1; size++)
+   {
+      std::string buf(size + 1, 'x');
+      CHECK(need == root.write(&buf[0], size, NULL));
+      CHECK((size_t) size - 1 == strlen(buf.c_str()) or size > need);
+      CHECK('x' == buf[size]);
+   }
+}
+
+static void test_file()
+{
+   std::string path = temp_file(json);
+   Doc_t doc;
+   CHECK(doc.parse_file(path.c_str()));
+   CHECK(2.5 == (double) doc.root()["n"][1]);
+   unlink(path.c_str());
+
+   CHECK(not doc.parse_file("/nonexistent/icejson.json"));
+   CHECK("Unable to open file" == doc.error.desc);
+}
+
+/* the writer passes ints as long long whatever the format says, and
+ * falls back to its defaults for formats it can not use */
+static void test_formats()
+{
+   Doc_t doc;
+   Node_t &root = doc.parse_string("{\"i\":[255,-3000000000],\"f\":1.5,\"s\":\"x\"}");
+
+   doc.writer.int_format = "%d";
+   CHECK("{\"i\":[255,-3000000000],\"f\":1.500000,\"s\":\"x\"}" == text(root));
+
+   doc.writer.int_format = "%#06x";
+   doc.writer.float_format = "%.2Lf";
+   CHECK("{\"i\":[0x00ff,0xffffffff4d2fa200],\"f\":1.50,\"s\":\"x\"}" == text(root));
+
+   doc.writer.int_format = "%s";
+   doc.writer.float_format = "%g %g";
+   doc.writer.str_format = "%*s";
+   CHECK("{\"i\":[255,-3000000000],\"f\":1.500000,\"s\":\"x\"}" == text(root));
+
+   doc.writer.int_format = "<%5d%%>";
+   CHECK("{\"i\":[<  255%>,<-3000000000%>]" == text(root).substr(0, 30));
+}
+
+int main()
+{
+   test_sinks();
+   test_bounded();
+   test_file();
+   test_formats();
+   return report("test_writer");
+}